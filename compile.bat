@@ -1,37 +1,52 @@
-cls
-@echo off
-setlocal enabledelayedexpansion
-
-rem Check if game name is correct (by DeepSeek)
-for %%g in (TIC_TAC_TOE GOMOKU) do (
-	if "%1"=="%%g" (
-		goto :execute
-	)
-)
-
-echo Unknown game: %1
-exit /b 1
-
-:execute
-echo Date: %date%
-echo Time: %time%
-echo Game: %1
-echo Device: Terminal
-echo;
-
-call g++ -std=c++14 -Wall -O2 src\export\terminal.cpp -DGAME_%1 -o dist\windows_gcc\%1_GCC.exe
-IF %ERRORLEVEL% EQU 0 (
-	echo G++ OK
-) ELSE (
-	echo G++ ERROR %ERRORLEVEL%
-	exit /b %ERRORLEVEL%
-)
-
-call cl /std:c++14 /w /O2 /fp:fast src\export\terminal.cpp -DGAME_%1 /Fedist\windows\%1.exe
-IF %ERRORLEVEL% EQU 0 (
-	echo MSVC OK
-	start dist\windows\%1.exe
-) ELSE (
-	echo MSVC ERROR %ERRORLEVEL%
-	exit /b %ERRORLEVEL%
+cls
+@echo off
+setlocal enabledelayedexpansion
+
+rem Check if game name is correct (by DeepSeek)
+for %%g in (TIC_TAC_TOE GOMOKU) do (
+	if "%1"=="%%g" (
+		goto :device
+	)
+)
+
+echo Unknown game: %1
+exit /b 1
+
+:device
+rem Optional second argument: name of a file in src\export (default: terminal)
+set DEVICE=terminal
+set TARGET=%1
+if not "%2"=="" (
+	set DEVICE=%2
+	set TARGET=%1_%2
+)
+if not exist src\export\%DEVICE%.cpp (
+	echo Unknown device: %DEVICE%
+	exit /b 1
+)
+
+:execute
+echo Date: %date%
+echo Time: %time%
+echo Game: %1
+echo Device: %DEVICE%
+echo;
+
+call g++ -std=c++14 -Wall -O2 -pthread src\export\%DEVICE%.cpp -DGAME_%1 -o dist\windows_gcc\%TARGET%_GCC.exe
+IF %ERRORLEVEL% EQU 0 (
+	echo G++ OK
+) ELSE (
+	echo G++ ERROR %ERRORLEVEL%
+	exit /b %ERRORLEVEL%
+)
+
+call cl /std:c++14 /w /O2 /fp:fast src\export\%DEVICE%.cpp -DGAME_%1 /Fedist\windows\%TARGET%.exe
+IF %ERRORLEVEL% EQU 0 (
+	echo MSVC OK
+	if "%DEVICE%"=="terminal" (
+		start dist\windows\%TARGET%.exe
+	)
+) ELSE (
+	echo MSVC ERROR %ERRORLEVEL%
+	exit /b %ERRORLEVEL%
 )
\ No newline at end of file
@@ -1,2 +1,2 @@
-@echo off
+@echo off
 call D:\Softwares\MicrosoftVisualStudio\2022\Community\VC\Auxiliary\Build\vcvars64.bat
\ No newline at end of file
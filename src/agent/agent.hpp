@@ -1,22 +1,97 @@
-#pragma once
-
-#include "../game/game.hpp"
-
-#include <istream>
-#include <ostream>
-
-namespace AlphaYa
-{
-	template <typename StateType>
-	class Agent
-	{
-	public:
-		static constexpr IndexType players = StateType::players;
-
-		typedef StateType State;
-		typedef typename State::Action Action;
-		typedef typename State::Data Data;
-
-		virtual Action move(const State &state, std::istream &in, std::ostream &out) = 0;
-	};
+#pragma once
+
+#include "../game/game.hpp"
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <istream>
+#include <memory>
+#include <ostream>
+
+namespace AlphaYa
+{
+	/*
+	Shared cancellation flag of a move
+	Copies share the flag, so the caller keeps one copy to stop the search which checks another.
+	A default token can be stopped too, but nobody else holds it.
+	*/
+	class StopToken
+	{
+	public:
+		std::shared_ptr<std::atomic<bool>> flag;
+
+		StopToken() : flag(std::make_shared<std::atomic<bool>>(false)) {}
+
+		void stop() const
+		{
+			flag->store(true, std::memory_order_relaxed);
+		}
+
+		bool stopped() const
+		{
+			return flag->load(std::memory_order_relaxed);
+		}
+	};
+
+	template <typename StateType>
+	class Agent
+	{
+	public:
+		static constexpr IndexType players = StateType::players;
+
+		typedef StateType State;
+		typedef typename State::Action Action;
+		typedef typename State::Data Data;
+
+		/*
+		Progress of a search: the number of simulations so far, the current best action,
+		and its value for the player to move in [-1, 1]
+		*/
+		typedef std::function<void(IndexType, const Action &, float)> Progress;
+
+		/*
+		Result of a cancellable move, whose action is only valid if found
+		A search stopped before it has any action, such as a human who has not answered yet, is not found.
+		*/
+		class SearchResult
+		{
+		public:
+			Action action;
+			bool found;
+		};
+
+		virtual ~Agent() {}
+
+		/*
+		Blocking move for the player to move
+		*/
+		virtual Action move(const State &state, std::istream &in, std::ostream &out) = 0;
+
+		/*
+		Cancellable move: once stop is stopped, return the best action found so far as soon as possible,
+		or a result which is not found if there is none yet, and report the progress of the search to progress if it is not empty
+		Agents which cannot be cancelled make their blocking move.
+		*/
+		virtual SearchResult search(const State &state, std::istream &in, std::ostream &out, const StopToken &stop, const Progress &progress)
+		{
+			return SearchResult{move(state, in, out), true};
+		}
+
+		/*
+		Run search on a new thread, returns the future result
+		state is copied, but in, out and the agent must outlive the future, and no other move of the agent may run meanwhile.
+		A deadline is imposed by waiting for the future until the deadline and stopping stop.
+		The destructor of the future waits for the search, so a cancelled move is stopped before its future is dropped.
+		Progress is reported on the search thread.
+		*/
+		std::future<SearchResult> move_async(const State &state, std::istream &in, std::ostream &out, const StopToken &stop = StopToken(), const Progress &progress = Progress())
+		{
+			const auto run = [this, state, &in, &out, stop, progress]()
+			{
+				return search(state, in, out, stop, progress);
+			};
+			return std::async(std::launch::async, run);
+		}
+	};
 };
\ No newline at end of file
@@ -1,47 +1,127 @@
-#pragma once
-
-#include "agent.hpp"
-
-#include <istream>
-#include <ostream>
-#include <sstream>
-#include <string>
-#include <unordered_map>
-
-namespace AlphaYa
-{
-	template <typename StateType>
-	class InputAgent : public Agent<StateType>
-	{
-	public:
-		static constexpr IndexType players = StateType::players;
-
-		typedef StateType State;
-		typedef typename State::Action Action;
-		typedef typename State::Data Data;
-
-		Action move(const State &state, std::istream &in, std::ostream &out)
-		{
-			std::unordered_map<std::string, Action> actions;
-			for (const Action &action : state.generateActions())
-			{
-				std::ostringstream out;
-				action.output(out);
-				const std::string description = out.str();
-				actions.emplace(description, action);
-			}
-			for (std::string input;;)
-			{
-				out << "Please input your move: ";
-				std::getline(in, input);
-				typename std::unordered_map<std::string, Action>::const_iterator it = actions.find(input);
-				if (it == actions.end())
-				{
-					out << "No such move" << std::endl;
-					continue;
-				}
-				return it->second;
-			}
-		}
-	};
+#pragma once
+
+#include "agent.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace AlphaYa
+{
+	/*
+	Reader of lines of a stream on a detached thread, so that waiting for a line can be abandoned
+	A line which arrives after its wait is abandoned is kept for the next wait.
+	The stream must outlive a pending read, as std::cin does, and should not be read by others meanwhile.
+	*/
+	class LineReader : public std::enable_shared_from_this<LineReader>
+	{
+	public:
+		std::mutex mutex;
+		std::condition_variable condition;
+		std::deque<std::string> lines;
+		bool reading;
+
+		LineReader() : reading(false) {}
+
+		/*
+		Wait for the next line of in into line, returns false if stop is stopped first
+		stop is polled, since it cannot wake the wait.
+		*/
+		bool read(std::istream &in, const StopToken &stop, std::string &line)
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			if (lines.empty() && !reading)
+			{
+				// A failed stream does not block
+				if (!in)
+				{
+					std::getline(in, line);
+					return true;
+				}
+				reading = true;
+				const std::shared_ptr<LineReader> self = shared_from_this();
+				std::thread([self, &in]()
+				{
+					std::string input;
+					std::getline(in, input);
+					std::lock_guard<std::mutex> lock(self->mutex);
+					self->lines.push_back(input);
+					self->reading = false;
+					self->condition.notify_all();
+				}).detach();
+			}
+			while (lines.empty())
+			{
+				if (stop.stopped())
+				{
+					return false;
+				}
+				condition.wait_for(lock, std::chrono::milliseconds(50));
+			}
+			line = lines.front();
+			lines.pop_front();
+			return true;
+		}
+	};
+
+	template <typename StateType>
+	class InputAgent : public Agent<StateType>
+	{
+	public:
+		static constexpr IndexType players = StateType::players;
+
+		typedef StateType State;
+		typedef typename State::Action Action;
+		typedef typename State::Data Data;
+		typedef typename Agent<StateType>::Progress Progress;
+		typedef typename Agent<StateType>::SearchResult SearchResult;
+
+		std::shared_ptr<LineReader> reader;
+
+		InputAgent() : reader(std::make_shared<LineReader>()) {}
+
+		Action move(const State &state, std::istream &in, std::ostream &out)
+		{
+			return search(state, in, out, StopToken(), Progress()).action;
+		}
+
+		/*
+		Lines are read by reader, so that a stopped search returns at once, without an action,
+		while its line is still awaited. Progress is never reported.
+		*/
+		SearchResult search(const State &state, std::istream &in, std::ostream &out, const StopToken &stop, const Progress &progress)
+		{
+			std::unordered_map<std::string, Action> actions;
+			for (const Action &action : state.generateActions())
+			{
+				std::ostringstream out;
+				action.output(out);
+				const std::string description = out.str();
+				actions.emplace(description, action);
+			}
+			for (std::string input;;)
+			{
+				out << "Please input your move: ";
+				if (!reader->read(in, stop, input))
+				{
+					return SearchResult{Action(), false};
+				}
+				typename std::unordered_map<std::string, Action>::const_iterator it = actions.find(input);
+				if (it == actions.end())
+				{
+					out << "No such move" << std::endl;
+					continue;
+				}
+				return SearchResult{it->second, true};
+			}
+		}
+	};
 };
\ No newline at end of file
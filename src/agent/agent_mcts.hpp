@@ -1,218 +1,1233 @@
-#pragma once
-
-#include "agent.hpp"
-
-#include <algorithm>
-#include <cmath>
-#include <cstdint>
-#include <istream>
-#include <memory>
-#include <ostream>
-#include <random>
-#include <unordered_map>
-#include <vector>
-
-namespace AlphaYa
-{
-	template <typename StateType>
-	class MCTSAgent : public Agent<StateType>
-	{
-	public:
-		static constexpr IndexType players = StateType::players;
-
-		typedef StateType State;
-		typedef typename State::Action Action;
-		typedef typename State::Data Data;
-		typedef std::mt19937::result_type SeedType;
-
-		typedef float EvalType;
-
-		std::mt19937 rd;
-		EvalType c;
-		IndexType simulate_count;
-		IndexType log_interval;
-
-		MCTSAgent(SeedType seed, EvalType cc, IndexType s, IndexType l) : rd(seed), c(cc), simulate_count(s), log_interval(l) {}
-
-		class Node
-		{
-		public:
-			bool is_final;
-			ScoreType count, scores[players];
-			State state;
-			std::weak_ptr<Node> father;
-
-			class Child
-			{
-			public:
-				Action action;
-				std::shared_ptr<Node> node;
-				Child(const Action &a) : action(a) {}
-			};
-
-			std::vector<Child> children;
-
-			Node(const State &s, std::mt19937 &rd) : state(s)
-			{
-				is_final = state.calculateScore(scores);
-				count = 0;
-				children.clear();
-				if (!is_final)
-				{
-					for (IndexType player = 0; player < players; ++player)
-					{
-						scores[player] = 0;
-					}
-					const std::vector<Action> actions = state.generateActions();
-					children.reserve(actions.size());
-					for (const Action &action : actions)
-					{
-						children.emplace_back(action);
-					}
-					std::shuffle(children.begin(), children.end(), rd);
-				}
-			}
-
-			bool best_action(Action &action) const
-			{
-				ScoreType best = 0;
-				for (const Child &child : children)
-				{
-					if (!child.node)
-					{
-						return false;
-					}
-					if (best < child.node->count)
-					{
-						best = child.node->count;
-						action = child.action;
-					}
-				}
-				return true;
-			}
-		};
-		std::shared_ptr<Node> root;
-
-		static std::shared_ptr<Node> find_state(std::shared_ptr<Node> node, const State &s)
-		{
-			const std::uint8_t *bytes = s.getBytes(), *node_bytes = node->state.getBytes();
-			if (std::equal(bytes, bytes + State::byte_count, node_bytes, node_bytes + State::byte_count))
-			{
-				return node;
-			}
-			for (const typename Node::Child &child : node->children)
-			{
-				if (child.node)
-				{
-					std::shared_ptr<Node> ret = find_state(child.node, s);
-					if (ret)
-					{
-						return ret;
-					}
-				}
-			}
-			return std::shared_ptr<Node>();
-		}
-
-		static std::shared_ptr<Node> explore(std::shared_ptr<Node> node, const EvalType c, std::mt19937 &rd)
-		{
-			IndexType player = node->state.toMove();
-			for (typename Node::Child &child : node->children)
-			{
-				if (!child.node)
-				{
-					State next_state = node->state;
-					next_state.move(child.action);
-					child.node = std::make_shared<Node>(next_state, rd);
-					child.node->father = std::weak_ptr<Node>(node);
-					return child.node;
-				}
-			}
-			EvalType best = -INFINITY;
-			const EvalType k = c * std::sqrt(std::log((EvalType)node->count));
-			std::shared_ptr<Node> best_node;
-			for (const typename Node::Child &child : node->children)
-			{
-				const std::shared_ptr<Node> &node = child.node;
-				const EvalType count = (EvalType)(node->count);
-				EvalType average = (EvalType)(node->scores[player]);
-				if (!node->is_final)
-				{
-					average /= count;
-				}
-				const EvalType eval = average + k / std::sqrt(count);
-				if (best < eval)
-				{
-					best = eval;
-					best_node = node;
-				}
-			}
-			return best_node;
-		}
-
-		Action move(const State &state, std::istream &in, std::ostream &out)
-		{
-			if (root)
-			{
-				root = find_state(root, state);
-			}
-			if (!root)
-			{
-				root = std::make_shared<Node>(state, rd);
-			}
-
-			bool has_action = false;
-			Action action;
-			for (IndexType i = 1;; ++i)
-			{
-				std::shared_ptr<Node> p = root;
-				do
-				{
-					p = explore(p, c, rd);
-				} while (!p->is_final);
-				++p->count;
-				const ScoreType *scores = p->scores;
-				do
-				{
-					p = p->father.lock();
-					++p->count;
-					for (IndexType player = 0; player < players; ++player)
-					{
-						p->scores[player] += scores[player];
-					}
-				} while (p != root);
-				if (root->best_action(action))
-				{
-					has_action = true;
-				}
-				if ((i % log_interval == 0 || i >= simulate_count) && has_action)
-				{
-					IndexType player = root->state.toMove();
-					EvalType expected = 0.0;
-					for (const typename Node::Child &child : root->children)
-					{
-						if (action == child.action)
-						{
-							if (child.node->is_final)
-							{
-								expected = ((EvalType)child.node->scores[player]);
-							}
-							else
-							{
-								expected = ((EvalType)child.node->scores[player]) / ((EvalType)child.node->count);
-							}
-							break;
-						}
-					}
-					out << i << ": ";
-					action.output(out);
-					out << " " << expected << std::endl;
-				}
-				if (has_action && i >= simulate_count)
-				{
-					return action;
-				}
-			}
-		}
-	};
+#pragma once
+
+#include "agent.hpp"
+#include "arena.hpp"
+#include "checkpoint.hpp"
+#include "heuristic.hpp"
+#include "playout.hpp"
+#include "trace.hpp"
+#include "ucb.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace AlphaYa
+{
+	template <typename StateType>
+	class MCTSAgent : public Agent<StateType>
+	{
+	public:
+		static constexpr IndexType players = StateType::players;
+
+		typedef StateType State;
+		typedef typename State::Action Action;
+		typedef typename State::Data Data;
+		typedef std::mt19937::result_type SeedType;
+
+		typedef float EvalType;
+		typedef typename Agent<StateType>::Progress Progress;
+		typedef typename Agent<StateType>::SearchResult SearchResult;
+
+		std::mt19937 rd;
+		EvalType c;
+		IndexType simulate_count;
+		IndexType log_interval;
+
+		/*
+		Pondering: keep searching the subtree of our own move during the opponent's turn
+		The search stops when the opponent's move arrives, or when the tree uses more than ponder_memory bytes.
+		*/
+		bool ponder;
+		IndexType ponder_memory;
+
+		/*
+		RAVE: blend all-moves-as-first (AMAF) statistics into the value of children
+		The weight of AMAF value is sqrt(rave / (3 * count + rave)), 0 to disable RAVE.
+		See: https://www.chessprogramming.org/UCT#RAVE
+		*/
+		EvalType rave;
+
+		/*
+		Memory budget of the tree in bytes, 0 for no limit
+		When the tree uses more than max_memory bytes, low-visit subtrees are evicted, see evict.
+		*/
+		IndexType max_memory;
+
+		/*
+		Checkpoint file of the tree, empty to disable
+		The tree is loaded from the file before the first move if the file exists, and saved to it after every
+		checkpoint_interval moves and when the agent is destroyed, since saving costs time in proportion to the tree.
+		See save_tree and load_tree.
+		*/
+		std::string checkpoint;
+		bool checkpoint_loaded;
+		IndexType checkpoint_interval;
+		IndexType checkpoint_moves;
+
+		/*
+		Optional heuristic, see set_heuristic
+		root_heuristic is at the root state, and heuristic follows the current simulation.
+		*/
+		std::unique_ptr<Heuristic<State>> root_heuristic, heuristic;
+		EvalType bias;
+
+		/*
+		Stop every simulation at the first new node, and score it by the evaluation of heuristic, see set_heuristic
+		*/
+		bool leaf_evaluation;
+
+		/*
+		Weight of an evaluated leaf in games, as many as a batch of random playouts
+		Final leaves are given the same weight when simulations stop at new leaves.
+		*/
+		static constexpr ScoreType leaf_games = 16;
+
+		/*
+		Gumbel root search: sample gumbel_count root actions without replacement,
+		and split simulate_count simulations among them by sequential halving, 0 to use UCB at the root
+		See gumbel_search.
+		*/
+		IndexType gumbel_count;
+
+		/*
+		Time budget of a move in milliseconds, 0 for no limit
+		The search stops at simulate_count simulations or when the time is up, whichever comes first.
+		Gumbel root search only uses simulate_count, since it plans its phases in advance.
+		*/
+		IndexType move_time;
+
+		/*
+		Compaction: relocate the reused tree into a fresh arena at the start of every move,
+		and incrementally while pondering, see compact
+		*/
+		bool compaction;
+
+		MCTSAgent(SeedType seed, EvalType cc, IndexType s, IndexType l, bool p = false, IndexType pm = 0, EvalType r = 0, IndexType mm = 0, const std::string &cp = "", IndexType g = 0, IndexType mt = 0, bool cm = false) : rd(seed), c(cc), simulate_count(s), log_interval(l), ponder(p), ponder_memory(pm), rave(r), max_memory(mm), checkpoint(cp), checkpoint_loaded(false), checkpoint_interval(10), checkpoint_moves(0), bias(0), leaf_evaluation(false), gumbel_count(g), move_time(mt), compaction(cm), memory(0), ponder_count(0), evict_count(0), pondering(false), ponder_stop(false) {}
+
+		~MCTSAgent()
+		{
+			stop_ponder();
+			if (root && !checkpoint.empty() && checkpoint_moves)
+			{
+				save_tree(checkpoint);
+			}
+			// Events of pondering after the last move are written as one more search
+			if (tracer && (tracer->ring.tail != tracer->ring.head || tracer->ring.dropped))
+			{
+				tracer->dump();
+			}
+		}
+
+		class Node
+		{
+		public:
+			bool is_final;
+			ScoreType count, scores[players];
+			State state;
+
+			/*
+			prior is the prior weight of action given by the heuristic, 0 without heuristic
+			amaf_count and amaf_score are the AMAF statistics of action,
+			for the player to move at the father node
+			*/
+			class Child
+			{
+			public:
+				Action action;
+				EvalType prior;
+				std::shared_ptr<Node> node;
+				ScoreType amaf_count, amaf_score;
+				Child(const Action &a, EvalType p = 0) : action(a), prior(p), amaf_count(0), amaf_score(0) {}
+			};
+
+			typedef std::vector<Child, ArenaAllocator<Child>> ChildList;
+			typedef std::vector<EvalType, ArenaAllocator<EvalType>> StatList;
+
+			/*
+			children only holds expanded children, the other actions are in untried
+			Once untried is empty, stats holds the statistics of children for selection:
+			values in [0, stats_size), and inverse square roots of counts in [stats_size, 2 * stats_size),
+			see ucb_argmax and update_child
+			Both are allocated from the heap, or from the arena of the node after compaction.
+			*/
+			ChildList children;
+			typename State::ActionSet untried;
+			StatList stats;
+			IndexType stats_size;
+
+			Node(const State &s) : state(s)
+			{
+				is_final = state.calculateScore(scores);
+				count = 0;
+				stats_size = 0;
+				untried.clear();
+				if (!is_final)
+				{
+					for (IndexType player = 0; player < players; ++player)
+					{
+						scores[player] = 0;
+					}
+					state.generateActionSet(untried);
+				}
+			}
+
+			/*
+			Copy of other whose children list and statistics are allocated from allocator,
+			with the capacity of the children list of other, so that both use the same memory
+			The children point to the same nodes as the children of other.
+			*/
+			Node(const Node &other, const ArenaAllocator<Node> &allocator) : is_final(other.is_final), count(other.count), state(other.state), children(allocator), untried(other.untried), stats(other.stats.begin(), other.stats.end(), allocator), stats_size(other.stats_size)
+			{
+				for (IndexType player = 0; player < players; ++player)
+				{
+					scores[player] = other.scores[player];
+				}
+				children.reserve(other.children.capacity());
+				children.insert(children.end(), other.children.begin(), other.children.end());
+			}
+
+			/*
+			Drop all children and keep count and scores, so that the node becomes a leaf again
+			Returns the number of dropped nodes.
+			*/
+			IndexType collapse()
+			{
+				IndexType dropped = 0;
+				for (Child &child : children)
+				{
+					dropped += child.node->size();
+				}
+				ChildList().swap(children);
+				StatList().swap(stats);
+				stats_size = 0;
+				if (!is_final)
+				{
+					state.generateActionSet(untried);
+				}
+				return dropped;
+			}
+
+			/*
+			Number of nodes in the subtree
+			*/
+			IndexType size() const
+			{
+				IndexType total = 1;
+				for (const Child &child : children)
+				{
+					total += child.node->size();
+				}
+				return total;
+			}
+
+			bool best_action(Action &action) const
+			{
+				if (!untried.empty())
+				{
+					return false;
+				}
+				ScoreType best = 0;
+				for (const Child &child : children)
+				{
+					if (best < child.node->count)
+					{
+						best = child.node->count;
+						action = child.action;
+					}
+				}
+				return true;
+			}
+
+			/*
+			Average score of player over the simulations through the node
+			*/
+			EvalType average(IndexType player) const
+			{
+				return is_final ? (EvalType)scores[player] : ((EvalType)scores[player]) / ((EvalType)count);
+			}
+		};
+		std::shared_ptr<Node> root;
+
+		static std::shared_ptr<Node> find_state(std::shared_ptr<Node> node, const State &s)
+		{
+			const std::uint8_t *bytes = s.getBytes(), *node_bytes = node->state.getBytes();
+			if (std::equal(bytes, bytes + State::byte_count, node_bytes, node_bytes + State::byte_count))
+			{
+				return node;
+			}
+			for (const typename Node::Child &child : node->children)
+			{
+				if (child.node)
+				{
+					std::shared_ptr<Node> ret = find_state(child.node, s);
+					if (ret)
+					{
+						return ret;
+					}
+				}
+			}
+			return std::shared_ptr<Node>();
+		}
+
+		/*
+		Search the next moves with simulations simulations and for time milliseconds, where 0 keeps the current budget
+		With only a time, UCB search runs until the time is up, while Gumbel root search keeps simulate_count,
+		since it plans its phases by simulations.
+		*/
+		void set_budget(IndexType simulations, IndexType time)
+		{
+			if (time)
+			{
+				move_time = time;
+			}
+			if (simulations)
+			{
+				simulate_count = simulations;
+			}
+			else if (time && !gumbel_count)
+			{
+				simulate_count = std::numeric_limits<IndexType>::max();
+			}
+		}
+
+		/*
+		Use heuristic h to choose untried actions with probability proportional to their priors,
+		and add progressive bias b * prior / (count + 1) to the values of children
+		With leaf evaluation e, simulations stop at new leaves, which are scored by the evaluation v of h
+		for the player to move as leaf_games games with the sum of results round(v * leaf_games),
+		so that the statistics stay integer sums of results of two player games. It takes precedence over playouts.
+		See: https://www.chessprogramming.org/UCT#Progressive_Bias
+		*/
+		void set_heuristic(std::unique_ptr<Heuristic<State>> h, EvalType b, bool e = false)
+		{
+			root_heuristic = std::move(h);
+			heuristic = root_heuristic->clone();
+			bias = b;
+			leaf_evaluation = e;
+		}
+
+		/*
+		Untried actions and their priors of the current expansion
+		*/
+		std::vector<std::pair<IndexType, EvalType>> candidates;
+
+		/*
+		Choose an untried action of node by the priors of heuristic, which should be at the state of node
+		Returns the index of the action, and writes its prior into prior.
+		*/
+		IndexType sample_untried(const Node &node, EvalType &prior)
+		{
+			candidates.clear();
+			EvalType total = 0;
+			for (IndexType w = 0; w < State::ActionSet::word_count; ++w)
+			{
+				for (std::uint64_t bits = node.untried.words[w]; bits; bits &= bits - 1)
+				{
+					const IndexType index = (w << 6) + lowest_bit(bits);
+					const EvalType weight = heuristic->prior(Action::fromIndex(index));
+					candidates.emplace_back(index, weight);
+					total += weight;
+				}
+			}
+			EvalType r = std::uniform_real_distribution<EvalType>(0, total)(rd);
+			for (const std::pair<IndexType, EvalType> &candidate : candidates)
+			{
+				r -= candidate.second;
+				if (r < 0)
+				{
+					prior = candidate.second;
+					return candidate.first;
+				}
+			}
+			prior = candidates.back().second;
+			return candidates.back().first;
+		}
+
+		/*
+		Expand the untried action of node with index action_index
+		Returns the index of the new child in node.children.
+		*/
+		static IndexType expand(Node &node, IndexType action_index, EvalType prior)
+		{
+			node.untried.reset(action_index);
+			node.children.emplace_back(Action::fromIndex(action_index), prior);
+			typename Node::Child &child = node.children.back();
+			State next_state = node.state;
+			next_state.move(child.action);
+			child.node = std::make_shared<Node>(next_state);
+			return node.children.size() - 1;
+		}
+
+		/*
+		Choose a child of node, expanding an untried action if there is any
+		Returns the index of the child in node.children.
+		*/
+		IndexType explore(Node &node)
+		{
+			if (!node.untried.empty())
+			{
+				EvalType prior = 0;
+				const IndexType index = heuristic ? sample_untried(node, prior) : node.untried.select(std::uniform_int_distribution<IndexType>(0, node.untried.count() - 1)(rd));
+				return expand(node, index, prior);
+			}
+			if (!node.stats_size)
+			{
+				node.stats_size = (node.children.size() + ucb_width - 1) / ucb_width * ucb_width;
+				node.stats.assign(node.stats_size * 2, 0);
+				std::fill(node.stats.begin(), node.stats.begin() + node.stats_size, -INFINITY);
+				for (IndexType index = 0; index < node.children.size(); ++index)
+				{
+					update_child(node, index);
+				}
+			}
+			const EvalType k = c * ucb_sqrt_log(node.count);
+			const IndexType index = ucb_argmax(node.stats.data(), node.stats.data() + node.stats_size, node.stats_size, k);
+			prefetch(node.children[index].node.get());
+			return index;
+		}
+
+		/*
+		Recompute the selection statistics of a child from its node and AMAF statistics
+		*/
+		void update_child(Node &node, IndexType index) const
+		{
+			if (!node.stats_size)
+			{
+				return;
+			}
+			const typename Node::Child &child = node.children[index];
+			const Node &child_node = *child.node;
+			const EvalType count = (EvalType)(child_node.count);
+			EvalType average = (EvalType)(child_node.scores[node.state.toMove()]);
+			if (!child_node.is_final)
+			{
+				average /= count;
+				if (rave > 0 && child.amaf_count)
+				{
+					const EvalType beta = std::sqrt(rave / (3 * count + rave));
+					average = (1 - beta) * average + beta * ((EvalType)child.amaf_score) / ((EvalType)child.amaf_count);
+				}
+				average += bias * child.prior / (count + 1);
+			}
+			node.stats[index] = average;
+			node.stats[node.stats_size + index] = ucb_inv_sqrt(child_node.count);
+		}
+
+		/*
+		Update AMAF statistics along path with the total final scores of games
+		A child gets the scores if its action is played later in the simulation by the same player.
+		*/
+		void update_amaf(const ScoreType scores[players], ScoreType games)
+		{
+			typename State::ActionSet played[players];
+			for (IndexType player = 0; player < players; ++player)
+			{
+				played[player].clear();
+			}
+			for (IndexType depth = path.size(); depth--;)
+			{
+				Node &node = *path[depth].first;
+				const IndexType player = node.state.toMove();
+				played[player].set(node.children[path[depth].second].action.index());
+				for (IndexType index = 0; index < node.children.size(); ++index)
+				{
+					typename Node::Child &child = node.children[index];
+					if (played[player].test(child.action.index()))
+					{
+						child.amaf_count += games;
+						child.amaf_score += scores[player];
+						update_child(node, index);
+					}
+				}
+			}
+		}
+
+		/*
+		Estimated memory used by a node, its children list and selection statistics
+		*/
+		static IndexType node_memory(const Node &node)
+		{
+			return sizeof(Node) + node.children.capacity() * sizeof(typename Node::Child) + node.stats_size * 2 * sizeof(EvalType);
+		}
+
+		static IndexType tree_memory(const std::shared_ptr<Node> &node)
+		{
+			IndexType memory = node_memory(*node);
+			for (const typename Node::Child &child : node->children)
+			{
+				if (child.node)
+				{
+					memory += tree_memory(child.node);
+				}
+			}
+			return memory;
+		}
+
+		/*
+		Nodes and indices of chosen children of the current simulation
+		*/
+		std::vector<std::pair<Node *, IndexType>> path;
+
+		/*
+		Optional random playouts, see set_playout
+		*/
+		std::unique_ptr<Playout<State>> playout;
+
+		/*
+		Stop every simulation at the first new node, and evaluate it by a batch of random playouts p,
+		instead of expanding nodes down to the end of the game
+		Every game of the batch counts as a visit of the nodes on the path.
+		*/
+		void set_playout(std::unique_ptr<Playout<State>> p)
+		{
+			playout = std::move(p);
+		}
+
+		/*
+		Optional trace of simulations, see set_trace
+		event is the event of the current simulation.
+		*/
+		std::unique_ptr<Tracer> tracer;
+		TraceEvent event;
+
+		/*
+		Record an event of every simulation into a ring buffer of capacity events,
+		which is appended to the trace file at path after every move, see Tracer
+		*/
+		void set_trace(const std::string &path, IndexType capacity)
+		{
+			static_assert(State::action_count <= trace_no_action, "action indices should fit in 16 bits");
+			tracer = std::make_unique<Tracer>(path, capacity);
+		}
+
+		static constexpr IndexType any_child = (IndexType)-1;
+
+		/*
+		Run one simulation from root through the child with index first (any_child to explore),
+		and returns estimated memory of newly created nodes
+		*/
+		IndexType simulate(IndexType first = any_child)
+		{
+			IndexType memory = 0;
+			path.clear();
+			Node *p = root.get();
+			if (tracer)
+			{
+				tracer->begin(event, pondering);
+			}
+			if (heuristic)
+			{
+				heuristic->assign(*root_heuristic);
+			}
+			do
+			{
+				const bool expanding = tracer && (!path.empty() || first == any_child) && !p->untried.empty();
+				const std::uint64_t start = expanding ? trace_cycles() : 0;
+				const IndexType index = path.empty() && first != any_child ? first : explore(*p);
+				if (expanding)
+				{
+					event.expand_cycles += (std::uint32_t)(trace_cycles() - start);
+					if (!event.expanded_count++)
+					{
+						event.expanded_action = (std::uint16_t)p->children[index].action.index();
+					}
+				}
+				path.emplace_back(p, index);
+				if (heuristic)
+				{
+					heuristic->move(p->children[index].action);
+				}
+				p = p->children[index].node.get();
+				if (!p->count)
+				{
+					memory += node_memory(*p) + sizeof(typename Node::Child) + 2 * sizeof(EvalType);
+					if (playout || leaf_evaluation)
+					{
+						break;
+					}
+				}
+			} while (!p->is_final);
+			ScoreType totals[players];
+			ScoreType games = 1;
+			const ScoreType *scores = p->scores;
+			if (p->is_final)
+			{
+				// Weigh a final leaf as an evaluated one, so that proven results are not diluted by batches of games
+				if (playout || leaf_evaluation)
+				{
+					for (IndexType player = 0; player < players; ++player)
+					{
+						totals[player] = p->scores[player] * leaf_games;
+					}
+					games = leaf_games;
+					scores = totals;
+				}
+			}
+			else
+			{
+				for (IndexType player = 0; player < players; ++player)
+				{
+					totals[player] = 0;
+				}
+				const std::uint64_t playout_start = tracer ? trace_cycles() : 0;
+				if (leaf_evaluation)
+				{
+					const IndexType player = p->state.toMove();
+					const ScoreType result = (ScoreType)std::lround(heuristic->evaluate() * leaf_games);
+					for (IndexType q = 0; q < players; ++q)
+					{
+						totals[q] = q == player ? result : -result;
+					}
+					games = leaf_games;
+				}
+				else
+				{
+					games = playout->play(p->state, totals);
+				}
+				if (tracer)
+				{
+					event.playout_cycles = (std::uint32_t)(trace_cycles() - playout_start);
+				}
+				for (IndexType player = 0; player < players; ++player)
+				{
+					p->scores[player] += totals[player];
+				}
+				scores = totals;
+			}
+			const std::uint64_t backup_start = tracer ? trace_cycles() : 0;
+			p->count += games;
+			for (const std::pair<Node *, IndexType> &step : path)
+			{
+				Node &node = *step.first;
+				node.count += games;
+				for (IndexType player = 0; player < players; ++player)
+				{
+					node.scores[player] += scores[player];
+				}
+			}
+			if (rave > 0)
+			{
+				update_amaf(scores, games);
+			}
+			else
+			{
+				for (const std::pair<Node *, IndexType> &step : path)
+				{
+					update_child(*step.first, step.second);
+				}
+			}
+			if (tracer)
+			{
+				const std::uint64_t end = trace_cycles();
+				event.select_cycles = (std::uint32_t)(backup_start - event.cycles - event.expand_cycles - event.playout_cycles);
+				event.backup_cycles = (std::uint32_t)(end - backup_start);
+				event.depth = (std::uint16_t)path.size();
+				event.root_action = (std::uint16_t)root->children[path.front().second].action.index();
+				event.result = (std::int16_t)scores[root->state.toMove()];
+				tracer->ring.push(event);
+			}
+			return memory;
+		}
+
+		/*
+		Collapse every node below node with count less than threshold
+		Returns the number of dropped nodes.
+		*/
+		static IndexType collapse(Node &node, ScoreType threshold)
+		{
+			IndexType dropped = 0;
+			for (typename Node::Child &child : node.children)
+			{
+				Node &child_node = *child.node;
+				dropped += child_node.count < threshold ? child_node.collapse() : collapse(child_node, threshold);
+			}
+			return dropped;
+		}
+
+		/*
+		Evict the least visited subtrees until the tree uses at most 3/4 of max_memory
+		Nodes with count less than a threshold are collapsed into leaves, keeping their statistics,
+		and the threshold doubles until enough memory is freed.
+		Since the count of a node is at most the count of its father, the most visited paths are kept.
+		With compaction, memory freed in the arena is only released with the arena,
+		so the tree is relocated into a new arena by a full compaction pass once the freed memory
+		exceeds a quarter of the tree, which bounds the cost of passes by the memory they release.
+		*/
+		void evict()
+		{
+			for (ScoreType threshold = 2; memory > max_memory / 4 * 3 && threshold <= root->count; threshold <<= 1)
+			{
+				evict_count += collapse(*root, threshold);
+				memory = tree_memory(root);
+			}
+			if (compaction && arena_waste() > memory / 4)
+			{
+				compact_root.reset();
+				compact();
+			}
+		}
+
+		typedef CheckpointNode<players> Record;
+
+		static void save_node(std::ostream &fout, const Node &node, const typename Node::Child *edge)
+		{
+			Record record;
+			record.action = edge ? (std::uint32_t)edge->action.index() : 0;
+			record.child_count = (std::uint32_t)node.children.size();
+			record.count = node.count;
+			record.amaf_count = edge ? edge->amaf_count : 0;
+			record.amaf_score = edge ? edge->amaf_score : 0;
+			for (IndexType player = 0; player < players; ++player)
+			{
+				record.scores[player] = node.scores[player];
+			}
+			fout.write((const char *)&record, sizeof(record));
+			for (const typename Node::Child &child : node.children)
+			{
+				save_node(fout, *child.node, &child);
+			}
+		}
+
+		/*
+		Write the tree to path, returns false on failure
+		The file is written to path.tmp and then renamed, so an old checkpoint is never left half written.
+		*/
+		bool save_tree(const std::string &path) const
+		{
+			std::ostringstream sout;
+			root->state.output(sout, "");
+			std::string state_string = sout.str();
+			state_string.resize((state_string.size() + 8) / 8 * 8, '\0');
+			CheckpointHeader header;
+			header.magic = checkpoint_magic;
+			header.players = players;
+			header.action_count = State::action_count;
+			header.node_count = root->size();
+			header.state_length = state_string.size();
+			const std::string temp_path = path + ".tmp";
+			{
+				std::ofstream fout(temp_path, std::ios::binary);
+				fout.write((const char *)&header, sizeof(header));
+				fout.write(state_string.data(), state_string.size());
+				save_node(fout, *root, nullptr);
+				fout.close();
+				if (fout.fail())
+				{
+					std::remove(temp_path.c_str());
+					return false;
+				}
+			}
+			if (std::rename(temp_path.c_str(), path.c_str()))
+			{
+				std::remove(path.c_str());
+				if (std::rename(temp_path.c_str(), path.c_str()))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		/*
+		Rebuild node and its subtree from the records at cursor, returns false if the records are invalid
+		States of children are replayed from the state of node.
+		*/
+		static bool load_node(Node &node, const Record &record, const std::uint8_t *&cursor, const std::uint8_t *end)
+		{
+			node.count = record.count;
+			if (!node.is_final)
+			{
+				for (IndexType player = 0; player < players; ++player)
+				{
+					node.scores[player] = record.scores[player];
+				}
+			}
+			node.children.reserve(record.child_count);
+			for (IndexType i = 0; i < record.child_count; ++i)
+			{
+				if ((IndexType)(end - cursor) < sizeof(Record))
+				{
+					return false;
+				}
+				Record child_record;
+				std::memcpy(&child_record, cursor, sizeof(Record));
+				cursor += sizeof(Record);
+				if (child_record.action >= State::action_count || !node.untried.test(child_record.action))
+				{
+					return false;
+				}
+				node.untried.reset(child_record.action);
+				node.children.emplace_back(Action::fromIndex(child_record.action));
+				typename Node::Child &child = node.children.back();
+				child.amaf_count = child_record.amaf_count;
+				child.amaf_score = child_record.amaf_score;
+				State next_state = node.state;
+				next_state.move(child.action);
+				child.node = std::make_shared<Node>(next_state);
+				if (!load_node(*child.node, child_record, cursor, end))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		/*
+		Read a tree written by save_tree, returns an empty pointer on failure
+		The file is memory mapped and read once in order, so that the page cache does the buffering.
+		*/
+		static std::shared_ptr<Node> load_tree(const std::string &path)
+		{
+			MappedFile file;
+			if (!file.open(path) || file.size < sizeof(CheckpointHeader))
+			{
+				return std::shared_ptr<Node>();
+			}
+			CheckpointHeader header;
+			std::memcpy(&header, file.data, sizeof(header));
+			if (header.magic != checkpoint_magic || header.players != players || header.action_count != State::action_count || !header.node_count || !header.state_length || header.state_length % 8 || header.state_length > file.size - sizeof(header) || (file.size - sizeof(header)) / sizeof(Record) < header.node_count || file.size != sizeof(header) + header.state_length + header.node_count * sizeof(Record))
+			{
+				return std::shared_ptr<Node>();
+			}
+			const std::uint8_t *cursor = file.data + sizeof(header);
+			if (cursor[header.state_length - 1])
+			{
+				return std::shared_ptr<Node>();
+			}
+			State state;
+			state.init(std::string((const char *)cursor));
+			cursor += header.state_length;
+			Record record;
+			std::memcpy(&record, cursor, sizeof(Record));
+			cursor += sizeof(Record);
+			std::shared_ptr<Node> node = std::make_shared<Node>(state);
+			// The tree must consist of exactly node_count records
+			if (!load_node(*node, record, cursor, file.data + file.size) || cursor != file.data + file.size)
+			{
+				return std::shared_ptr<Node>();
+			}
+			return node;
+		}
+
+		IndexType memory;
+		IndexType ponder_count;
+		IndexType evict_count;
+		bool pondering;
+		std::atomic<bool> ponder_stop;
+		std::thread ponder_thread;
+
+		void ponder_loop()
+		{
+			while (!ponder_stop && memory < ponder_memory)
+			{
+				if (max_memory && memory + arena_waste() > max_memory)
+				{
+					evict();
+				}
+				if (compaction)
+				{
+					compact(256);
+				}
+				memory += simulate();
+				++ponder_count;
+			}
+		}
+
+		void start_ponder()
+		{
+			ponder_stop = false;
+			ponder_count = 0;
+			pondering = true;
+			ponder_thread = std::thread(&MCTSAgent::ponder_loop, this);
+		}
+
+		void stop_ponder()
+		{
+			if (ponder_thread.joinable())
+			{
+				ponder_stop = true;
+				ponder_thread.join();
+				pondering = false;
+			}
+		}
+
+		/*
+		State of the compaction pass: the root it started from, the allocator of its arena,
+		and the children which are not relocated yet, as relocated parents and indices of children
+		*/
+		std::weak_ptr<Node> compact_root;
+		ArenaAllocator<Node> compact_allocator;
+		std::vector<std::pair<std::shared_ptr<Node>, IndexType>> compact_stack;
+
+		/*
+		Bytes freed in the arena of compaction, which tree_memory does not count but are not released yet
+		The arena of an unfinished earlier pass is released when the pass finishes.
+		*/
+		IndexType arena_waste() const
+		{
+			return compact_allocator.arena ? compact_allocator.arena->freed : 0;
+		}
+
+		/*
+		Push the children of node to compact_stack, so that the most visited child is relocated first
+		*/
+		void push_children(const std::shared_ptr<Node> &node)
+		{
+			const IndexType begin = compact_stack.size();
+			for (IndexType index = 0; index < node->children.size(); ++index)
+			{
+				compact_stack.emplace_back(node, index);
+			}
+			const auto fewer = [&node](const std::pair<std::shared_ptr<Node>, IndexType> &a, const std::pair<std::shared_ptr<Node>, IndexType> &b)
+			{
+				return node->children[a.second].node->count < node->children[b.second].node->count;
+			};
+			std::sort(compact_stack.begin() + begin, compact_stack.end(), fewer);
+		}
+
+		/*
+		Relocate the tree into a fresh arena in depth-first order, visiting children by decreasing visits,
+		so that every node is followed by its children list, its selection statistics and its most visited subtree.
+		Subtrees kept after a move lose their siblings, which leaves them scattered among freed memory.
+		The pass is incremental: every call relocates at most limit nodes and continues the pass of the last call,
+		and a new pass starts when the root changes. The tree stays valid between calls,
+		since a relocated node points to the old nodes of its children until they are relocated too.
+		Old nodes are freed with their last reference, and the arena with its last node.
+		Returns the number of nodes relocated.
+		*/
+		IndexType compact(IndexType limit = std::numeric_limits<IndexType>::max())
+		{
+			if (!root || !limit)
+			{
+				return 0;
+			}
+			IndexType relocated = 0;
+			if (compact_root.lock() != root)
+			{
+				compact_stack.clear();
+				compact_allocator = ArenaAllocator<Node>(std::make_shared<Arena>(std::max(memory + memory / 4, (IndexType)1 << 16)));
+				root = std::allocate_shared<Node>(compact_allocator, *root, compact_allocator);
+				compact_root = root;
+				push_children(root);
+				++relocated;
+			}
+			while (relocated < limit && !compact_stack.empty())
+			{
+				const std::pair<std::shared_ptr<Node>, IndexType> top = compact_stack.back();
+				compact_stack.pop_back();
+				// Children dropped by evict since they were pushed are skipped
+				if (top.second >= top.first->children.size())
+				{
+					continue;
+				}
+				std::shared_ptr<Node> &child = top.first->children[top.second].node;
+				child = std::allocate_shared<Node>(compact_allocator, *child, compact_allocator);
+				push_children(child);
+				++relocated;
+			}
+			if (relocated)
+			{
+				memory = tree_memory(root);
+			}
+			return relocated;
+		}
+
+		/*
+		Run a simulation through the root child with index first, evicting subtrees if needed
+		*/
+		void simulate_child(IndexType first)
+		{
+			if (max_memory && memory + arena_waste() > max_memory)
+			{
+				evict();
+			}
+			memory += simulate(first);
+		}
+
+		/*
+		Gumbel root search with sequential halving
+		The top gumbel_count root actions by Gumbel noise plus log prior (0 without heuristic) are sampled,
+		which samples them without replacement from the prior.
+		Simulations are split into ceil(log2(gumbel_count)) phases, in which every remaining candidate gets
+		the same number of simulations, and the better half of candidates by
+		Gumbel noise + log prior + (50 + maximum count) * value is kept after each phase,
+		where values are normalized into [0, 1] among the candidates.
+		With few simulations, this improves the chosen action over UCB, which spreads them over all actions.
+		See: Danihelka et al., Policy improvement by planning with Gumbel, ICLR 2022
+		*/
+		Action gumbel_search(std::ostream &out, const StopToken &stop, const Progress &progress)
+		{
+			// Root children are reached through root after simulations, since eviction may relocate the root
+			Node &node = *root;
+			const IndexType player = node.state.toMove();
+			std::extreme_value_distribution<EvalType> gumbel;
+			candidates.clear();
+			for (const typename Node::Child &child : node.children)
+			{
+				candidates.emplace_back(child.action.index(), 0);
+			}
+			for (IndexType w = 0; w < State::ActionSet::word_count; ++w)
+			{
+				for (std::uint64_t bits = node.untried.words[w]; bits; bits &= bits - 1)
+				{
+					candidates.emplace_back((w << 6) + lowest_bit(bits), 0);
+				}
+			}
+			for (std::pair<IndexType, EvalType> &candidate : candidates)
+			{
+				candidate.second = gumbel(rd);
+				if (root_heuristic)
+				{
+					candidate.second += std::log(root_heuristic->prior(Action::fromIndex(candidate.first)));
+				}
+			}
+			const IndexType m = std::min(gumbel_count, (IndexType)candidates.size());
+			const auto higher = [](const std::pair<IndexType, EvalType> &a, const std::pair<IndexType, EvalType> &b)
+			{
+				return a.second > b.second;
+			};
+			std::partial_sort(candidates.begin(), candidates.begin() + m, candidates.end(), higher);
+
+			// Candidates as indices of root children and their Gumbel noise plus log prior
+			std::vector<std::pair<IndexType, EvalType>> chosen;
+			for (IndexType k = 0; k < m; ++k)
+			{
+				const IndexType action_index = candidates[k].first;
+				IndexType index = 0;
+				while (index < node.children.size() && node.children[index].action.index() != action_index)
+				{
+					++index;
+				}
+				if (index == node.children.size())
+				{
+					index = expand(node, action_index, root_heuristic ? root_heuristic->prior(Action::fromIndex(action_index)) : 0);
+				}
+				chosen.emplace_back(index, candidates[k].second);
+			}
+
+			IndexType phases = 1;
+			while ((((IndexType)1) << phases) < m)
+			{
+				++phases;
+			}
+			IndexType i = 0;
+			std::vector<std::pair<EvalType, IndexType>> ranking;
+			do
+			{
+				const IndexType visits = std::max(simulate_count / (phases * chosen.size()), (IndexType)1);
+				for (IndexType v = 0; v < visits && (!v || !stop.stopped()); ++v)
+				{
+					for (const std::pair<IndexType, EvalType> &candidate : chosen)
+					{
+						simulate_child(candidate.first);
+						++i;
+					}
+				}
+				ScoreType max_count = 0;
+				EvalType low = INFINITY, high = -INFINITY;
+				for (const typename Node::Child &child : root->children)
+				{
+					max_count = std::max(max_count, child.node->count);
+				}
+				for (const std::pair<IndexType, EvalType> &candidate : chosen)
+				{
+					const EvalType value = root->children[candidate.first].node->average(player);
+					low = std::min(low, value);
+					high = std::max(high, value);
+				}
+				ranking.clear();
+				for (IndexType k = 0; k < chosen.size(); ++k)
+				{
+					const EvalType value = root->children[chosen[k].first].node->average(player);
+					const EvalType normalized = high > low ? (value - low) / (high - low) : 0;
+					ranking.emplace_back(chosen[k].second + (50 + (EvalType)max_count) * normalized, k);
+				}
+				std::sort(ranking.begin(), ranking.end(), std::greater<std::pair<EvalType, IndexType>>());
+				// A stopped search keeps only the best candidate of the current phase
+				std::vector<std::pair<IndexType, EvalType>> kept;
+				for (IndexType k = 0; k < (stop.stopped() ? 1 : (chosen.size() + 1) / 2); ++k)
+				{
+					kept.push_back(chosen[ranking[k].second]);
+				}
+				chosen.swap(kept);
+				const Node &best = *root->children[chosen.front().first].node;
+				out << i << ": ";
+				root->children[chosen.front().first].action.output(out);
+				out << " " << best.average(player) << std::endl;
+				if (progress)
+				{
+					progress(i, root->children[chosen.front().first].action, best.average(player));
+				}
+			} while (chosen.size() > 1);
+			return root->children[chosen.front().first].action;
+		}
+
+		Action move(const State &state, std::istream &in, std::ostream &out)
+		{
+			return search(state, in, out, StopToken(), Progress()).action;
+		}
+
+		/*
+		Stopping ends the search after the current simulation once there is a best action,
+		or after the current round of simulations of Gumbel root search, which simulates every candidate at least once,
+		so the result is always found. Progress is reported after every simulation of UCB search once there is a best action,
+		and after every phase of Gumbel root search.
+		*/
+		SearchResult search(const State &state, std::istream &in, std::ostream &out, const StopToken &stop, const Progress &progress)
+		{
+			stop_ponder();
+			if (ponder_count)
+			{
+				out << "Pondered " << ponder_count << " simulations" << std::endl;
+				ponder_count = 0;
+			}
+			if (!root && !checkpoint.empty() && !checkpoint_loaded)
+			{
+				checkpoint_loaded = true;
+				root = load_tree(checkpoint);
+				if (root)
+				{
+					out << "Loaded " << root->size() << " nodes from " << checkpoint << std::endl;
+				}
+			}
+			if (root)
+			{
+				root = find_state(root, state);
+			}
+			if (!root)
+			{
+				root = std::make_shared<Node>(state);
+				memory = node_memory(*root);
+			}
+			else
+			{
+				memory = tree_memory(root);
+			}
+			if (compaction)
+			{
+				const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				const IndexType relocated = compact();
+				if (relocated > 1)
+				{
+					out << "Compacted " << relocated << " nodes in " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms" << std::endl;
+				}
+			}
+			if (root_heuristic)
+			{
+				root_heuristic->init(root->state);
+			}
+
+			Action action;
+			if (gumbel_count)
+			{
+				action = gumbel_search(out, stop, progress);
+			}
+			else
+			{
+				bool has_action = false;
+				const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(move_time);
+				for (IndexType i = 1;; ++i)
+				{
+					simulate_child(any_child);
+					if (root->best_action(action))
+					{
+						has_action = true;
+					}
+					const bool out_of_time = move_time && !(i & 63) && std::chrono::steady_clock::now() >= deadline;
+					const bool stopped = stop.stopped();
+					const bool log = i % log_interval == 0 || i >= simulate_count || out_of_time || stopped;
+					if ((log || progress) && has_action)
+					{
+						IndexType player = root->state.toMove();
+						EvalType expected = 0.0;
+						for (const typename Node::Child &child : root->children)
+						{
+							if (action == child.action)
+							{
+								expected = child.node->average(player);
+								break;
+							}
+						}
+						if (log)
+						{
+							out << i << ": ";
+							action.output(out);
+							out << " " << expected << std::endl;
+						}
+						if (progress)
+						{
+							progress(i, action, expected);
+						}
+					}
+					if (has_action && (i >= simulate_count || out_of_time || stopped))
+					{
+						break;
+					}
+				}
+			}
+			if (evict_count)
+			{
+				out << "Evicted " << evict_count << " nodes" << std::endl;
+				evict_count = 0;
+			}
+			if (!checkpoint.empty() && ++checkpoint_moves >= checkpoint_interval)
+			{
+				checkpoint_moves = 0;
+				if (!save_tree(checkpoint))
+				{
+					out << "Failed to save " << checkpoint << std::endl;
+				}
+			}
+			if (tracer)
+			{
+				if (tracer->ring.dropped)
+				{
+					out << "Trace dropped " << tracer->ring.dropped << " events" << std::endl;
+				}
+				if (!tracer->dump())
+				{
+					out << "Failed to write " << tracer->path << std::endl;
+				}
+			}
+			if (ponder)
+			{
+				for (const typename Node::Child &child : root->children)
+				{
+					if (action == child.action)
+					{
+						root = child.node;
+						break;
+					}
+				}
+				if (!root->is_final)
+				{
+					memory = tree_memory(root);
+					if (root_heuristic)
+					{
+						root_heuristic->init(root->state);
+					}
+					start_ponder();
+				}
+			}
+			return SearchResult{action, true};
+		}
+	};
 };
\ No newline at end of file
@@ -0,0 +1,322 @@
+#pragma once
+
+#include "agent.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <random>
+#include <vector>
+
+namespace AlphaYa
+{
+	/*
+	MCTS agent with compact nodes
+	Same search as MCTSAgent, but nodes live in one array and do not store states.
+	The state of a node is rebuilt by replaying actions from the root during selection.
+	*/
+	template <typename StateType>
+	class CompactMCTSAgent : public Agent<StateType>
+	{
+	public:
+		static constexpr IndexType players = StateType::players;
+
+		typedef StateType State;
+		typedef typename State::Action Action;
+		typedef typename State::Data Data;
+		typedef std::mt19937::result_type SeedType;
+
+		typedef float EvalType;
+		typedef std::uint32_t NodeIndex;
+
+		/*
+		Search stops at this many nodes, which leaves room for the nodes of one more simulation below the largest index
+		*/
+		static constexpr NodeIndex max_nodes = std::numeric_limits<NodeIndex>::max() / 2;
+
+		std::mt19937 rd;
+		EvalType c;
+		IndexType simulate_count;
+		IndexType log_interval;
+
+		CompactMCTSAgent(SeedType seed, EvalType cc, IndexType s, IndexType l) : rd(seed), c(cc), simulate_count(s), log_interval(l), root(0) {}
+
+		/*
+		Only created children are stored, as a linked list from children through next
+		untried is the number of actions of the node which have no child yet.
+		A created node is final, or has untried set to the number of its actions.
+		Scores of a final node are the final scores, otherwise the sum of final scores below it.
+		*/
+		class Node
+		{
+		public:
+			std::uint32_t count;
+			NodeIndex children, next;
+			EvalType scores[players];
+			std::uint16_t untried;
+			bool is_final;
+			Action action;
+
+			Node(const Action &a = Action()) : count(0), children(0), next(0), untried(0), is_final(false), action(a)
+			{
+				for (IndexType player = 0; player < players; ++player)
+				{
+					scores[player] = 0;
+				}
+			}
+		};
+
+		std::vector<Node> nodes;
+		NodeIndex root;
+		State root_state;
+
+		/*
+		Compute is_final and untried of a new node
+		*/
+		void create(NodeIndex index, const State &state)
+		{
+			Node &node = nodes[index];
+			ScoreType final_scores[players];
+			if (state.calculateScore(final_scores))
+			{
+				node.is_final = true;
+				for (IndexType player = 0; player < players; ++player)
+				{
+					node.scores[player] = (EvalType)final_scores[player];
+				}
+				return;
+			}
+			typename State::ActionSet actions;
+			state.generateActionSet(actions);
+			node.untried = (std::uint16_t)actions.count();
+		}
+
+		/*
+		Create a child for a uniformly random untried action
+		Untried actions are the legal actions without the actions of existing children.
+		*/
+		NodeIndex expand(NodeIndex index, State &state)
+		{
+			typename State::ActionSet actions;
+			state.generateActionSet(actions);
+			for (NodeIndex child = nodes[index].children; child; child = nodes[child].next)
+			{
+				actions.reset(nodes[child].action.index());
+			}
+			const Action action = Action::fromIndex(actions.select(std::uniform_int_distribution<IndexType>(0, nodes[index].untried - 1)(rd)));
+			const NodeIndex child = (NodeIndex)nodes.size();
+			nodes.emplace_back(action);
+			Node &node = nodes[index];
+			nodes[child].next = node.children;
+			node.children = child;
+			--node.untried;
+			state.move(action);
+			create(child, state);
+			return child;
+		}
+
+		NodeIndex explore(NodeIndex index, State &state)
+		{
+			const Node &node = nodes[index];
+			if (node.untried)
+			{
+				return expand(index, state);
+			}
+			const IndexType player = state.toMove();
+			EvalType best = -INFINITY;
+			const EvalType k = c * std::sqrt(std::log((EvalType)node.count));
+			NodeIndex best_child = 0;
+			for (NodeIndex child = node.children; child; child = nodes[child].next)
+			{
+				const Node &child_node = nodes[child];
+				const EvalType count = (EvalType)child_node.count;
+				EvalType average = child_node.scores[player];
+				if (!child_node.is_final)
+				{
+					average /= count;
+				}
+				const EvalType eval = average + k / std::sqrt(count);
+				if (best < eval)
+				{
+					best = eval;
+					best_child = child;
+				}
+			}
+			state.move(nodes[best_child].action);
+			return best_child;
+		}
+
+		bool best_action(Action &action) const
+		{
+			const Node &node = nodes[root];
+			if (node.untried)
+			{
+				return false;
+			}
+			std::uint32_t best = 0;
+			for (NodeIndex child = node.children; child; child = nodes[child].next)
+			{
+				if (best < nodes[child].count)
+				{
+					best = nodes[child].count;
+					action = nodes[child].action;
+				}
+			}
+			return true;
+		}
+
+		static bool same_state(const State &a, const State &b)
+		{
+			const std::uint8_t *bytes = a.getBytes(), *other_bytes = b.getBytes();
+			return std::equal(bytes, bytes + State::byte_count, other_bytes, other_bytes + State::byte_count);
+		}
+
+		/*
+		Find the node of s within depth levels below index, whose state is state
+		Returns false if not found.
+		*/
+		bool find_state(NodeIndex index, const State &state, const State &s, IndexType depth, NodeIndex &found) const
+		{
+			if (same_state(state, s))
+			{
+				found = index;
+				return true;
+			}
+			if (!depth)
+			{
+				return false;
+			}
+			const Node &node = nodes[index];
+			for (NodeIndex child = node.children; child; child = nodes[child].next)
+			{
+				State next_state = state;
+				next_state.move(nodes[child].action);
+				if (find_state(child, next_state, s, depth - 1, found))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		/*
+		Append the subtree of index to tree in depth-first order with remapped indices, returns the new index of index
+		*/
+		NodeIndex copy_subtree(NodeIndex index, std::vector<Node> &tree) const
+		{
+			const NodeIndex copied = (NodeIndex)tree.size();
+			tree.push_back(nodes[index]);
+			tree[copied].children = tree[copied].next = 0;
+			NodeIndex last = 0;
+			for (NodeIndex child = nodes[index].children; child; child = nodes[child].next)
+			{
+				const NodeIndex copied_child = copy_subtree(child, tree);
+				if (last)
+				{
+					tree[last].next = copied_child;
+				}
+				else
+				{
+					tree[copied].children = copied_child;
+				}
+				last = copied_child;
+			}
+			return copied;
+		}
+
+		Action move(const State &state, std::istream &in, std::ostream &out)
+		{
+			NodeIndex found = 0;
+			if (!nodes.empty() && find_state(root, root_state, state, players, found))
+			{
+				if (found != root)
+				{
+					std::vector<Node> tree;
+					copy_subtree(found, tree);
+					nodes.swap(tree);
+					root = 0;
+				}
+			}
+			else
+			{
+				nodes.clear();
+				nodes.emplace_back();
+				root = 0;
+				create(root, state);
+			}
+			root_state = state;
+
+			bool has_action = false;
+			Action action;
+			std::vector<NodeIndex> path;
+			for (IndexType i = 1;; ++i)
+			{
+				if (nodes.size() >= max_nodes)
+				{
+					if (!has_action)
+					{
+						action = nodes[nodes[root].children].action;
+					}
+					return action;
+				}
+				State current = root_state;
+				path.clear();
+				path.push_back(root);
+				do
+				{
+					path.push_back(explore(path.back(), current));
+				} while (!nodes[path.back()].is_final);
+				const Node &leaf = nodes[path.back()];
+				EvalType scores[players];
+				for (IndexType player = 0; player < players; ++player)
+				{
+					scores[player] = leaf.scores[player];
+				}
+				++nodes[path.back()].count;
+				path.pop_back();
+				for (const NodeIndex index : path)
+				{
+					Node &node = nodes[index];
+					++node.count;
+					for (IndexType player = 0; player < players; ++player)
+					{
+						node.scores[player] += scores[player];
+					}
+				}
+				if (best_action(action))
+				{
+					has_action = true;
+				}
+				if ((i % log_interval == 0 || i >= simulate_count) && has_action)
+				{
+					const IndexType player = root_state.toMove();
+					EvalType expected = 0.0;
+					const Node &node = nodes[root];
+					for (NodeIndex child = node.children; child; child = nodes[child].next)
+					{
+						const Node &child_node = nodes[child];
+						if (action == child_node.action)
+						{
+							expected = child_node.scores[player];
+							if (!child_node.is_final)
+							{
+								expected /= (EvalType)child_node.count;
+							}
+							break;
+						}
+					}
+					out << i << ": ";
+					action.output(out);
+					out << " " << expected << std::endl;
+				}
+				if (has_action && i >= simulate_count)
+				{
+					return action;
+				}
+			}
+		}
+	};
+};
\ No newline at end of file
@@ -1,33 +1,48 @@
-#pragma once
-
-#include "agent.hpp"
-
-#include <istream>
-#include <ostream>
-#include <random>
-#include <vector>
-
-namespace AlphaYa
-{
-	template <typename StateType>
-	class RandomAgent : public Agent<StateType>
-	{
-	public:
-		static constexpr IndexType players = StateType::players;
-
-		typedef StateType State;
-		typedef typename State::Action Action;
-		typedef typename State::Data Data;
-		typedef std::mt19937::result_type SeedType;
-
-		std::mt19937 rd;
-
-		RandomAgent(SeedType seed) : rd(seed) {}
-
-		Action move(const State &state, std::istream &in, std::ostream &out)
-		{
-			std::vector<Action> actions = state.generateActions();
-			return actions[std::uniform_int_distribution<IndexType>(0, actions.size() - 1)(rd)];
-		}
-	};
+#pragma once
+
+#include "agent.hpp"
+
+#include <istream>
+#include <ostream>
+#include <random>
+#include <vector>
+
+namespace AlphaYa
+{
+	template <typename StateType>
+	class RandomAgent : public Agent<StateType>
+	{
+	public:
+		static constexpr IndexType players = StateType::players;
+
+		typedef StateType State;
+		typedef typename State::Action Action;
+		typedef typename State::Data Data;
+		typedef std::mt19937::result_type SeedType;
+		typedef typename Agent<StateType>::Progress Progress;
+		typedef typename Agent<StateType>::SearchResult SearchResult;
+
+		std::mt19937 rd;
+
+		RandomAgent(SeedType seed) : rd(seed) {}
+
+		Action move(const State &state, std::istream &in, std::ostream &out)
+		{
+			return search(state, in, out, StopToken(), Progress()).action;
+		}
+
+		/*
+		The move is immediate, so stop is ignored, and progress is reported once with no simulations and value 0
+		*/
+		SearchResult search(const State &state, std::istream &in, std::ostream &out, const StopToken &stop, const Progress &progress)
+		{
+			std::vector<Action> actions = state.generateActions();
+			const Action action = actions[std::uniform_int_distribution<IndexType>(0, actions.size() - 1)(rd)];
+			if (progress)
+			{
+				progress(0, action, 0.0f);
+			}
+			return SearchResult{action, true};
+		}
+	};
 };
\ No newline at end of file
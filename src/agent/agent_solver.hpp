@@ -0,0 +1,53 @@
+#pragma once
+
+#include "agent.hpp"
+#include "dfpn.hpp"
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+
+namespace AlphaYa
+{
+	/*
+	Solver agent: play a proven win found by df-pn at once, and ask fallback otherwise
+	*/
+	template <typename StateType>
+	class SolverAgent : public Agent<StateType>
+	{
+	public:
+		static constexpr IndexType players = StateType::players;
+
+		typedef StateType State;
+		typedef typename State::Action Action;
+		typedef typename State::Data Data;
+		typedef DFPNSolver<State> Solver;
+
+		std::unique_ptr<Agent<State>> fallback;
+		Solver solver;
+		IndexType time_limit;
+		std::uint64_t node_limit;
+
+		/*
+		t is the time limit of df-pn in milliseconds, n is its node limit (0 for no limit),
+		and h is the size of its transposition table in bytes
+		*/
+		SolverAgent(std::unique_ptr<Agent<State>> f, IndexType t, std::uint64_t n, std::uint64_t h) : fallback(std::move(f)), solver(h), time_limit(t), node_limit(n) {}
+
+		Action move(const State &state, std::istream &in, std::ostream &out)
+		{
+			Action action;
+			const typename Solver::Result result = solver.solve(state, time_limit, node_limit, action);
+			out << "df-pn: " << (result == Solver::WIN ? "win" : result == Solver::NO_WIN ? "no win" : "unknown") << " after " << solver.nodes << " nodes" << std::endl;
+			if (result == Solver::WIN)
+			{
+				out << "Proven win: ";
+				action.output(out);
+				out << std::endl;
+				return action;
+			}
+			return fallback->move(state, in, out);
+		}
+	};
+};
\ No newline at end of file
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "../game/game.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace AlphaYa
+{
+	/*
+	Bump allocator of chunks of memory, which are only freed with the arena
+	Allocations are aligned to 16 bytes, and consecutive allocations are adjacent while they fit in the current chunk.
+	Freed allocations are only counted in freed, since their memory is not reused.
+	*/
+	class Arena
+	{
+	public:
+		static constexpr IndexType alignment = 16;
+
+		std::vector<std::unique_ptr<char[]>> chunks;
+		char *top;
+		IndexType left, chunk_size, used, freed;
+
+		Arena(IndexType c = 1 << 20) : top(nullptr), left(0), chunk_size(c), used(0), freed(0) {}
+
+		void *allocate(IndexType bytes)
+		{
+			bytes = (bytes + alignment - 1) & ~(alignment - 1);
+			if (bytes > left)
+			{
+				const IndexType size = std::max(bytes, chunk_size);
+				chunks.emplace_back(new char[size + alignment]);
+				top = chunks.back().get();
+				top += (alignment - (std::uintptr_t)top % alignment) % alignment;
+				left = size;
+			}
+			void *p = top;
+			top += bytes;
+			left -= bytes;
+			used += bytes;
+			return p;
+		}
+
+		void deallocate(IndexType bytes)
+		{
+			freed += (bytes + alignment - 1) & ~(alignment - 1);
+		}
+	};
+
+	/*
+	Standard allocator from a shared arena, or from the heap without arena
+	Memory from the arena is only released when the arena is destroyed, after the last allocator using it,
+	so containers and shared pointers created with the allocator keep their arena alive.
+	*/
+	template <typename T>
+	class ArenaAllocator
+	{
+	public:
+		typedef T value_type;
+		typedef std::true_type propagate_on_container_copy_assignment;
+		typedef std::true_type propagate_on_container_move_assignment;
+		typedef std::true_type propagate_on_container_swap;
+
+		std::shared_ptr<Arena> arena;
+
+		ArenaAllocator() {}
+		ArenaAllocator(const std::shared_ptr<Arena> &a) : arena(a) {}
+		template <typename U>
+		ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+		T *allocate(std::size_t n)
+		{
+			if (arena)
+			{
+				return (T *)arena->allocate(n * sizeof(T));
+			}
+			return (T *)::operator new(n * sizeof(T));
+		}
+
+		void deallocate(T *p, std::size_t n)
+		{
+			if (arena)
+			{
+				arena->deallocate(n * sizeof(T));
+			}
+			else
+			{
+				::operator delete(p);
+			}
+		}
+
+		template <typename U>
+		bool operator==(const ArenaAllocator<U> &other) const
+		{
+			return arena == other.arena;
+		}
+		template <typename U>
+		bool operator!=(const ArenaAllocator<U> &other) const
+		{
+			return arena != other.arena;
+		}
+	};
+};
\ No newline at end of file
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "../game/game.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace AlphaYa
+{
+	/*
+	Search tree checkpoint format
+	A file is a CheckpointHeader, the state string of the root padded with '\0' to a multiple of 8 bytes,
+	then node_count CheckpointNode records of the tree in preorder.
+	Integers are stored in the byte order of the machine, and magic reads "YACHPT01" on little-endian machines.
+	*/
+	constexpr std::uint64_t checkpoint_magic = 0x3130545048434159;
+
+	class CheckpointHeader
+	{
+	public:
+		std::uint64_t magic, players, action_count, node_count, state_length;
+	};
+
+	/*
+	A node with the statistics of the edge from its father
+	action, amaf_count and amaf_score are 0 for the root.
+	*/
+	template <IndexType players>
+	class CheckpointNode
+	{
+	public:
+		std::uint32_t action, child_count;
+		std::int64_t count, amaf_count, amaf_score, scores[players];
+	};
+
+	/*
+	Read-only memory mapping of a whole file
+	*/
+	class MappedFile
+	{
+	public:
+		const std::uint8_t *data;
+		IndexType size;
+#ifdef _WIN32
+		HANDLE file, mapping;
+#endif
+
+		MappedFile() : data(nullptr), size(0) {}
+
+		~MappedFile()
+		{
+			close();
+		}
+
+		MappedFile(const MappedFile &) = delete;
+		MappedFile &operator=(const MappedFile &) = delete;
+
+		/*
+		Map the file at path, returns false on failure or if the file is empty
+		*/
+		bool open(const std::string &path)
+		{
+			close();
+#ifdef _WIN32
+			file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+			if (file == INVALID_HANDLE_VALUE)
+			{
+				return false;
+			}
+			LARGE_INTEGER file_size;
+			if (!GetFileSizeEx(file, &file_size) || !file_size.QuadPart)
+			{
+				CloseHandle(file);
+				return false;
+			}
+			mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (!mapping)
+			{
+				CloseHandle(file);
+				return false;
+			}
+			data = (const std::uint8_t *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			if (!data)
+			{
+				CloseHandle(mapping);
+				CloseHandle(file);
+				return false;
+			}
+			size = (IndexType)file_size.QuadPart;
+#else
+			const int fd = ::open(path.c_str(), O_RDONLY);
+			if (fd < 0)
+			{
+				return false;
+			}
+			struct stat file_stat;
+			if (::fstat(fd, &file_stat) < 0 || !file_stat.st_size)
+			{
+				::close(fd);
+				return false;
+			}
+			void *address = ::mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			::close(fd);
+			if (address == MAP_FAILED)
+			{
+				return false;
+			}
+			::madvise(address, file_stat.st_size, MADV_SEQUENTIAL);
+			data = (const std::uint8_t *)address;
+			size = (IndexType)file_stat.st_size;
+#endif
+			return true;
+		}
+
+		void close()
+		{
+			if (!data)
+			{
+				return;
+			}
+#ifdef _WIN32
+			UnmapViewOfFile(data);
+			CloseHandle(mapping);
+			CloseHandle(file);
+#else
+			::munmap((void *)data, size);
+#endif
+			data = nullptr;
+			size = 0;
+		}
+	};
+};
\ No newline at end of file
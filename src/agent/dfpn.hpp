@@ -0,0 +1,296 @@
+#pragma once
+
+#include "../game/game.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace AlphaYa
+{
+	/*
+	Depth-first proof-number search (df-pn)
+	Proves whether the player to move at the root wins, where a draw counts as not winning.
+	Proof and disproof numbers are kept in a transposition table of fixed size,
+	in which the entries with the smallest searched subtrees are replaced first.
+	Repeated positions are not handled, so the game should never repeat a position.
+	See: https://www.chessprogramming.org/Proof-Number_Search#Depth-First_Proof-Number_Search
+	*/
+	template <typename StateType>
+	class DFPNSolver
+	{
+	public:
+		static constexpr IndexType players = StateType::players;
+
+		typedef StateType State;
+		typedef typename State::Action Action;
+		typedef std::uint32_t NumberType;
+
+		enum Result
+		{
+			UNKNOWN,
+			WIN,
+			NO_WIN
+		};
+
+		static NumberType infinity()
+		{
+			return 0x7FFFFFFF;
+		}
+
+		/*
+		amount is the number of nodes searched below the entry
+		key 0 marks an empty entry
+		*/
+		class Entry
+		{
+		public:
+			std::uint64_t key, amount;
+			NumberType pn, dn;
+		};
+		static constexpr IndexType bucket_size = 4;
+
+		std::unique_ptr<Entry[]> table;
+		std::uint64_t bucket_mask;
+		IndexType root_player;
+		bool table_used;
+
+		std::uint64_t nodes, node_limit;
+		std::chrono::steady_clock::time_point deadline;
+		bool aborted;
+
+		/*
+		hash_bytes is the size of transposition table in bytes, at least one bucket is used
+		*/
+		DFPNSolver(std::uint64_t hash_bytes) : root_player(0), table_used(false), nodes(0), node_limit(0), aborted(false)
+		{
+			std::uint64_t size = 1;
+			while ((size << 1) * bucket_size * sizeof(Entry) <= hash_bytes)
+			{
+				size <<= 1;
+			}
+			table.reset(new Entry[size * bucket_size]);
+			bucket_mask = size - 1;
+			clear();
+		}
+
+		void clear()
+		{
+			for (std::uint64_t i = 0; i < (bucket_mask + 1) * bucket_size; ++i)
+			{
+				table[i].key = 0;
+			}
+			table_used = false;
+		}
+
+		/*
+		Hash of state as a table key, which is never 0
+		*/
+		static std::uint64_t hash(const State &state)
+		{
+			const std::uint64_t h = state.hash();
+			return h ? h : 1;
+		}
+
+		/*
+		Proof and disproof numbers of a state from the table, 1 and 1 if not found
+		*/
+		void lookup(std::uint64_t key, NumberType &pn, NumberType &dn) const
+		{
+			const Entry *bucket = &table[(key & bucket_mask) * bucket_size];
+			for (IndexType i = 0; i < bucket_size; ++i)
+			{
+				if (bucket[i].key == key)
+				{
+					pn = bucket[i].pn;
+					dn = bucket[i].dn;
+					return;
+				}
+			}
+			pn = 1;
+			dn = 1;
+		}
+
+		void store(std::uint64_t key, NumberType pn, NumberType dn, std::uint64_t amount)
+		{
+			Entry *bucket = &table[(key & bucket_mask) * bucket_size];
+			Entry *target = bucket;
+			for (IndexType i = 0; i < bucket_size; ++i)
+			{
+				if (bucket[i].key == key || !bucket[i].key)
+				{
+					target = bucket + i;
+					break;
+				}
+				if (bucket[i].amount < target->amount)
+				{
+					target = bucket + i;
+				}
+			}
+			target->key = key;
+			target->amount = amount;
+			target->pn = pn;
+			target->dn = dn;
+		}
+
+		/*
+		Check if the final scores are a win of root_player
+		*/
+		bool wins(const ScoreType scores[players]) const
+		{
+			for (IndexType player = 0; player < players; ++player)
+			{
+				if (player != root_player && scores[player] >= scores[root_player])
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		static NumberType add(NumberType a, NumberType b)
+		{
+			return a + b >= infinity() ? infinity() : a + b;
+		}
+
+		/*
+		A child of the node being searched
+		Final children are never looked up, since the table may lose them.
+		*/
+		class Child
+		{
+		public:
+			Action action;
+			std::uint64_t key;
+			bool is_final;
+			NumberType pn, dn;
+		};
+
+		/*
+		Search state until its proof number reaches th_pn or its disproof number reaches th_dn
+		Writes proof and disproof numbers into pn and dn, and returns the number of searched nodes.
+		Children are searched by making and taking back their moves on state.
+		If proof is not null and the node is proven, the action of the proving child is written into it,
+		since the table may have lost the entry of that child by the time the search returns.
+		*/
+		std::uint64_t mid(State &state, std::uint64_t key, NumberType th_pn, NumberType th_dn, NumberType &pn, NumberType &dn, Action *proof = nullptr)
+		{
+			++nodes;
+			if (!(nodes & 1023) && (nodes >= node_limit || std::chrono::steady_clock::now() >= deadline))
+			{
+				aborted = true;
+			}
+			if (aborted)
+			{
+				lookup(key, pn, dn);
+				return 1;
+			}
+			table_used = true;
+			const bool is_or = state.toMove() == root_player;
+			std::vector<Child> children;
+			for (const Action &action : state.generateActions())
+			{
+				children.emplace_back();
+				Child &child = children.back();
+				child.action = action;
+				const typename State::Undo undo = state.move(action);
+				child.key = hash(state);
+				ScoreType scores[players];
+				child.is_final = state.calculateScore(scores);
+				if (child.is_final)
+				{
+					const bool win = wins(scores);
+					child.pn = win ? 0 : infinity();
+					child.dn = win ? infinity() : 0;
+				}
+				state.undo(action, undo);
+			}
+			std::uint64_t amount = 1;
+			for (;;)
+			{
+				// OR node: pn is the minimum and dn is the sum, AND node: the other way round
+				NumberType minimum = infinity(), second = infinity(), sum = 0;
+				IndexType best = 0;
+				for (IndexType i = 0; i < children.size(); ++i)
+				{
+					Child &child = children[i];
+					if (!child.is_final)
+					{
+						lookup(child.key, child.pn, child.dn);
+					}
+					const NumberType value = is_or ? child.pn : child.dn;
+					if (value < minimum)
+					{
+						second = minimum;
+						minimum = value;
+						best = i;
+					}
+					else if (value < second)
+					{
+						second = value;
+					}
+					sum = add(sum, is_or ? child.dn : child.pn);
+				}
+				pn = is_or ? minimum : sum;
+				dn = is_or ? sum : minimum;
+				if (proof && is_or && !pn)
+				{
+					*proof = children[best].action;
+				}
+				if (pn >= th_pn || dn >= th_dn || aborted)
+				{
+					break;
+				}
+				Child &child = children[best];
+				NumberType child_th_pn, child_th_dn;
+				if (is_or)
+				{
+					child_th_pn = second + 1 < th_pn ? second + 1 : th_pn;
+					child_th_dn = add(th_dn - dn, child.dn);
+				}
+				else
+				{
+					child_th_pn = add(th_pn - pn, child.pn);
+					child_th_dn = second + 1 < th_dn ? second + 1 : th_dn;
+				}
+				const typename State::Undo undo = state.move(child.action);
+				amount += mid(state, child.key, child_th_pn, child_th_dn, child.pn, child.dn);
+				state.undo(child.action, undo);
+			}
+			store(key, pn, dn, amount);
+			return amount;
+		}
+
+		/*
+		Solve state for the player to move within milliseconds and max_nodes nodes (0 for no limit)
+		If the result is WIN, a winning action is written into action.
+		*/
+		Result solve(const State &state, IndexType milliseconds, std::uint64_t max_nodes, Action &action)
+		{
+			ScoreType scores[players];
+			if (state.calculateScore(scores))
+			{
+				return UNKNOWN;
+			}
+			if (table_used && root_player != state.toMove())
+			{
+				clear();
+			}
+			root_player = state.toMove();
+			nodes = 0;
+			node_limit = max_nodes ? max_nodes : std::numeric_limits<std::uint64_t>::max();
+			deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(milliseconds);
+			aborted = false;
+			State current = state;
+			NumberType pn, dn;
+			mid(current, hash(state), infinity(), infinity(), pn, dn, &action);
+			if (dn == 0)
+			{
+				return NO_WIN;
+			}
+			return pn ? UNKNOWN : WIN;
+		}
+	};
+};
\ No newline at end of file
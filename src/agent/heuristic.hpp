@@ -0,0 +1,47 @@
+#pragma once
+
+#include "../game/game.hpp"
+
+#include <memory>
+
+namespace AlphaYa
+{
+	/*
+	Game specific knowledge used by search agents
+	A heuristic follows a game from init(state) through move(action) incrementally,
+	and judges the state it has reached for the player to move.
+	*/
+	template <typename StateType>
+	class Heuristic
+	{
+	public:
+		typedef StateType State;
+		typedef typename State::Action Action;
+
+		virtual ~Heuristic() {}
+
+		virtual std::unique_ptr<Heuristic> clone() const = 0;
+
+		/*
+		Copy the position of other, which should have the same type
+		*/
+		virtual void assign(const Heuristic &other) = 0;
+
+		virtual void init(const State &state) = 0;
+
+		/*
+		Make action for the player to move
+		*/
+		virtual void move(const Action &action) = 0;
+
+		/*
+		Prior probability weight of a legal action for the player to move, in (0, 1]
+		*/
+		virtual float prior(const Action &action) const = 0;
+
+		/*
+		Static evaluation for the player to move, in [-1, 1]
+		*/
+		virtual float evaluate() const = 0;
+	};
+};
\ No newline at end of file
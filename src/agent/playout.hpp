@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../game/game.hpp"
+
+#include <memory>
+
+namespace AlphaYa
+{
+	/*
+	Random playouts used by search agents to evaluate leaves
+	A playout plays a batch of random games from a state which is not over,
+	and adds the final scores of every player over the batch into totals.
+	*/
+	template <typename StateType>
+	class Playout
+	{
+	public:
+		static constexpr IndexType players = StateType::players;
+
+		typedef StateType State;
+
+		virtual ~Playout() {}
+
+		/*
+		Returns the number of games played
+		*/
+		virtual IndexType play(const State &state, ScoreType totals[players]) = 0;
+	};
+};
\ No newline at end of file
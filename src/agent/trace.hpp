@@ -0,0 +1,188 @@
+#pragma once
+
+#include "../game/game.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define ALPHAYA_TRACE_RDTSC
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace AlphaYa
+{
+	/*
+	Search trace format
+	A file is a sequence of searches, each a TraceHeader followed by event_count TraceEvent records,
+	one for every simulation of the search, including the simulations pondered before it.
+	Integers are stored in the byte order of the machine, and magic reads "YATRACE1" on little-endian machines.
+	*/
+	constexpr std::uint64_t trace_magic = 0x3145434152544159;
+
+	/*
+	dropped is the number of events lost because the ring buffer was full,
+	and cycles_per_second converts the cycle counts of the events into time.
+	*/
+	class TraceHeader
+	{
+	public:
+		std::uint64_t magic, search, event_count, dropped, cycles_per_second;
+	};
+
+	/*
+	Event of one simulation
+	cycles is the cycle counter at the start of the simulation.
+	select_cycles, expand_cycles, playout_cycles and backup_cycles are spent on descending without expanding,
+	creating new nodes, random playouts from the leaf and updating statistics.
+	root_action is the action index of the root child chosen, and expanded_action is the action index of
+	the first node created, or trace_no_action if the simulation created none.
+	result is the final score of the player to move at the root.
+	*/
+	class TraceEvent
+	{
+	public:
+		std::uint64_t cycles;
+		std::uint32_t simulation, select_cycles, expand_cycles, backup_cycles;
+		std::uint16_t depth, root_action, expanded_action, expanded_count;
+		std::int16_t result;
+		std::uint16_t pondered;
+		std::uint32_t playout_cycles;
+	};
+	static_assert(sizeof(TraceEvent) == 40, "trace events should be packed");
+
+	constexpr std::uint16_t trace_no_action = 0xFFFF;
+
+	/*
+	Cycle counter, or nanoseconds of steady clock if the processor has none
+	*/
+	inline std::uint64_t trace_cycles()
+	{
+#ifdef ALPHAYA_TRACE_RDTSC
+		return __rdtsc();
+#else
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
+
+	/*
+	Lock-free single producer, single consumer ring buffer of trace events
+	A full ring drops new events instead of blocking the search, and counts them in dropped.
+	*/
+	class TraceRing
+	{
+	public:
+		std::unique_ptr<TraceEvent[]> events;
+		std::uint64_t capacity;
+		std::atomic<std::uint64_t> head, tail, dropped;
+
+		/*
+		capacity is rounded up to a power of 2
+		*/
+		TraceRing(IndexType c) : capacity(1), head(0), tail(0), dropped(0)
+		{
+			while (capacity < c)
+			{
+				capacity <<= 1;
+			}
+			events.reset(new TraceEvent[capacity]);
+		}
+
+		void push(const TraceEvent &event)
+		{
+			const std::uint64_t t = tail.load(std::memory_order_relaxed);
+			if (t - head.load(std::memory_order_acquire) == capacity)
+			{
+				dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			events[t & (capacity - 1)] = event;
+			tail.store(t + 1, std::memory_order_release);
+		}
+
+		bool pop(TraceEvent &event)
+		{
+			const std::uint64_t h = head.load(std::memory_order_relaxed);
+			if (h == tail.load(std::memory_order_acquire))
+			{
+				return false;
+			}
+			event = events[h & (capacity - 1)];
+			head.store(h + 1, std::memory_order_release);
+			return true;
+		}
+	};
+
+	/*
+	Trace writer: events are pushed during a search, and appended to path as one search by dump
+	The cycle counter is calibrated against steady clock between dumps.
+	*/
+	class Tracer
+	{
+	public:
+		std::string path;
+		TraceRing ring;
+		std::uint64_t search;
+		std::uint32_t simulation;
+		std::uint64_t calibration_cycles;
+		std::chrono::steady_clock::time_point calibration_time;
+
+		Tracer(const std::string &p, IndexType capacity) : path(p), ring(capacity), search(0), simulation(0)
+		{
+			std::ofstream(path, std::ios::binary | std::ios::trunc);
+			calibrate();
+		}
+
+		void calibrate()
+		{
+			calibration_cycles = trace_cycles();
+			calibration_time = std::chrono::steady_clock::now();
+		}
+
+		/*
+		Start the event of a new simulation
+		*/
+		void begin(TraceEvent &event, bool pondered)
+		{
+			event = TraceEvent();
+			event.cycles = trace_cycles();
+			event.simulation = simulation++;
+			event.expanded_action = trace_no_action;
+			event.pondered = pondered;
+		}
+
+		/*
+		Append the events in the ring to path as a new search, returns false on failure
+		*/
+		bool dump()
+		{
+			const std::uint64_t cycles = trace_cycles();
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - calibration_time).count();
+			TraceHeader header;
+			header.magic = trace_magic;
+			header.search = search++;
+			header.event_count = ring.tail.load(std::memory_order_acquire) - ring.head.load(std::memory_order_relaxed);
+			header.dropped = ring.dropped.exchange(0);
+			header.cycles_per_second = seconds > 0 ? (std::uint64_t)((cycles - calibration_cycles) / seconds) : 0;
+			std::ofstream fout(path, std::ios::binary | std::ios::app);
+			fout.write((const char *)&header, sizeof(header));
+			TraceEvent event;
+			for (std::uint64_t i = 0; i < header.event_count && ring.pop(event); ++i)
+			{
+				fout.write((const char *)&event, sizeof(event));
+			}
+			simulation = 0;
+			calibrate();
+			fout.close();
+			return !fout.fail();
+		}
+	};
+};
\ No newline at end of file
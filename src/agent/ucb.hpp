@@ -0,0 +1,113 @@
+#pragma once
+
+#include "../game/game.hpp"
+#include "../game/bits.hpp"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ALPHAYA_UCB_SSE
+#include <emmintrin.h>
+#endif
+
+namespace AlphaYa
+{
+	/*
+	UCB child selection kernels
+	Children statistics are stored as structure of arrays, padded to a multiple of ucb_width.
+	A child with value v and inverse square root of count r is evaluated as v + k * r,
+	so padding slots use v = -INFINITY and r = 0.
+	*/
+	constexpr IndexType ucb_width = 4;
+
+	/*
+	Precomputed 1 / sqrt(n) and sqrt(log(n)) for small n
+	*/
+	class UCBTables
+	{
+	public:
+		static constexpr IndexType size = 4096;
+		float inv_sqrt[size], sqrt_log[size];
+
+		UCBTables()
+		{
+			inv_sqrt[0] = 0;
+			sqrt_log[0] = 0;
+			for (IndexType n = 1; n < size; ++n)
+			{
+				inv_sqrt[n] = (float)(1.0 / std::sqrt((double)n));
+				sqrt_log[n] = (float)std::sqrt(std::log((double)n));
+			}
+		}
+
+		static const UCBTables &get()
+		{
+			static const UCBTables tables;
+			return tables;
+		}
+	};
+
+	inline float ucb_inv_sqrt(std::uint64_t n)
+	{
+		return n < UCBTables::size ? UCBTables::get().inv_sqrt[n] : (float)(1.0 / std::sqrt((double)n));
+	}
+
+	inline float ucb_sqrt_log(std::uint64_t n)
+	{
+		return n < UCBTables::size ? UCBTables::get().sqrt_log[n] : (float)std::sqrt(std::log((double)n));
+	}
+
+	/*
+	Index of the first maximum of values[i] + k * inv_sqrt_counts[i] for i in [0, n)
+	n should be a positive multiple of ucb_width.
+	*/
+	inline IndexType ucb_argmax(const float *values, const float *inv_sqrt_counts, IndexType n, float k)
+	{
+#ifdef ALPHAYA_UCB_SSE
+		const __m128 kk = _mm_set1_ps(k);
+		__m128 best = _mm_set1_ps(-INFINITY);
+		for (IndexType i = 0; i < n; i += ucb_width)
+		{
+			const __m128 eval = _mm_add_ps(_mm_loadu_ps(values + i), _mm_mul_ps(kk, _mm_loadu_ps(inv_sqrt_counts + i)));
+			best = _mm_max_ps(best, eval);
+		}
+		best = _mm_max_ps(best, _mm_shuffle_ps(best, best, _MM_SHUFFLE(2, 3, 0, 1)));
+		best = _mm_max_ps(best, _mm_shuffle_ps(best, best, _MM_SHUFFLE(1, 0, 3, 2)));
+		for (IndexType i = 0; i < n; i += ucb_width)
+		{
+			const __m128 eval = _mm_add_ps(_mm_loadu_ps(values + i), _mm_mul_ps(kk, _mm_loadu_ps(inv_sqrt_counts + i)));
+			const int mask = _mm_movemask_ps(_mm_cmpeq_ps(eval, best));
+			if (mask)
+			{
+				return i + lowest_bit(mask);
+			}
+		}
+		return 0;
+#else
+		float best = -INFINITY;
+		IndexType best_index = 0;
+		for (IndexType i = 0; i < n; ++i)
+		{
+			const float eval = values[i] + k * inv_sqrt_counts[i];
+			if (best < eval)
+			{
+				best = eval;
+				best_index = i;
+			}
+		}
+		return best_index;
+#endif
+	}
+
+	/*
+	Hint the processor to load the cache line at address
+	*/
+	inline void prefetch(const void *address)
+	{
+#ifdef ALPHAYA_UCB_SSE
+		_mm_prefetch((const char *)address, _MM_HINT_T0);
+#elif defined(__GNUC__)
+		__builtin_prefetch(address);
+#endif
+	}
+};
\ No newline at end of file
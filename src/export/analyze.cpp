@@ -0,0 +1,228 @@
+#ifdef GAME_TIC_TAC_TOE
+#include "../mygames/tictactoe/export.hpp"
+#endif
+#ifdef GAME_GOMOKU
+#include "../mygames/gomoku/export.hpp"
+#endif
+
+#include "../game/thread_pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/*
+Batch analyzer: search every position of a file with the "ai" agent, in parallel on a thread pool
+Usage: analyze input PATH [output PATH] [threads N] [scount N] [time MS] [top K] [config CONFIG]
+config must be the last argument, since the agent config may contain spaces.
+Every line of the input is a state string in the format of init, and empty lines or lines starting with # are skipped.
+Every position is searched with scount simulations or for time milliseconds, whichever comes first
+(only time if scount is not given, and the budget of config if neither is given).
+Gumbel root search (config gumbel m) ignores time and uses the simulation budget.
+For every position, one line is written in input order, with tab-separated fields:
+state, best action, value of the best action for the player to move, simulations, and the top K root actions
+by visits as ACTION:SHARE. Positions which are over or cannot be searched get "-" fields.
+*/
+
+using AlphaYaExport::Action;
+using AlphaYaExport::Agent;
+using AlphaYaExport::IndexType;
+using AlphaYaExport::MCTSAgent;
+using AlphaYaExport::ScoreType;
+using AlphaYaExport::State;
+
+using AlphaYaExport::mcts_agent;
+using AlphaYaExport::players;
+
+/*
+Search the position state_string, and write its output line into result
+*/
+void analyze(const std::string &state_string, const std::string &config, IndexType simulate_count, IndexType move_time, IndexType top, std::shared_ptr<std::promise<std::string>> result)
+{
+	std::ostringstream sout;
+	sout << state_string << "\t";
+	State state;
+	state.init(state_string);
+	ScoreType scores[players];
+	std::unique_ptr<Agent> agent = mcts_agent(config);
+	MCTSAgent *mcts = dynamic_cast<MCTSAgent *>(agent.get());
+	if (state.calculateScore(scores) || !mcts)
+	{
+		sout << "-\t-\t-\t-\n";
+		result->set_value(sout.str());
+		return;
+	}
+	mcts->set_budget(simulate_count, move_time);
+	mcts->ponder = false;
+	std::istringstream in;
+	std::ostringstream log;
+	const Action action = mcts->move(state, in, log);
+
+	const MCTSAgent::Node &root = *mcts->root;
+	const IndexType player = root.state.toMove();
+	std::vector<std::pair<ScoreType, IndexType>> visits;
+	MCTSAgent::EvalType value = 0;
+	for (IndexType i = 0; i < root.children.size(); ++i)
+	{
+		const MCTSAgent::Node &child = *root.children[i].node;
+		visits.emplace_back(child.count, i);
+		if (root.children[i].action == action)
+		{
+			value = child.average(player);
+		}
+	}
+	std::sort(visits.begin(), visits.end(), std::greater<std::pair<ScoreType, IndexType>>());
+	action.output(sout);
+	sout << "\t" << value << "\t" << root.count << "\t";
+	for (IndexType k = 0; k < top && k < visits.size() && visits[k].first; ++k)
+	{
+		if (k)
+		{
+			sout << " ";
+		}
+		root.children[visits[k].second].action.output(sout);
+		sout << ":" << std::fixed << std::setprecision(3) << (double)visits[k].first / root.count;
+		sout.unsetf(std::ios::floatfield);
+	}
+	sout << "\n";
+	result->set_value(sout.str());
+}
+
+int main(int argc, char *argv[])
+{
+	std::ostream &out = std::cout;
+
+	std::string arguments;
+	for (int i = 1; i < argc; ++i)
+	{
+		arguments += argv[i];
+		arguments += " ";
+	}
+
+	std::string input_path;
+	std::string output_path;
+	IndexType thread_count = std::thread::hardware_concurrency();
+	IndexType simulate_count = 0;
+	IndexType move_time = 0;
+	IndexType top = 5;
+	std::string config;
+	std::string argument;
+	for (std::istringstream cfin(arguments);;)
+	{
+		cfin >> argument;
+		if (cfin.fail())
+		{
+			break;
+		}
+		if (argument == "input")
+		{
+			cfin >> input_path;
+			continue;
+		}
+		if (argument == "output")
+		{
+			cfin >> output_path;
+			continue;
+		}
+		if (argument == "threads")
+		{
+			cfin >> thread_count;
+			continue;
+		}
+		if (argument == "scount")
+		{
+			cfin >> simulate_count;
+			continue;
+		}
+		if (argument == "time")
+		{
+			cfin >> move_time;
+			continue;
+		}
+		if (argument == "top")
+		{
+			cfin >> top;
+			continue;
+		}
+		if (argument == "config")
+		{
+			cfin >> std::ws;
+			std::getline(cfin, config);
+			break;
+		}
+		out << "Unknown argument: " << argument << std::endl;
+		return 1;
+	}
+	std::ifstream fin(input_path);
+	if (fin.fail())
+	{
+		out << "Cannot open " << input_path << std::endl;
+		return 1;
+	}
+	std::vector<std::string> positions;
+	for (std::string line; std::getline(fin, line);)
+	{
+		if (!line.empty() && line.back() == '\r')
+		{
+			line.pop_back();
+		}
+		if (!line.empty() && line[0] != '#')
+		{
+			positions.push_back(line);
+		}
+	}
+	std::ofstream fout;
+	if (!output_path.empty())
+	{
+		fout.open(output_path);
+		if (fout.fail())
+		{
+			out << "Cannot open " << output_path << std::endl;
+			return 1;
+		}
+	}
+	std::ostream &result_out = output_path.empty() ? out : fout;
+
+	typedef std::chrono::steady_clock Clock;
+	const Clock::time_point start = Clock::now();
+	Clock::time_point last_report = start;
+	const auto speed = [&](IndexType done)
+	{
+		const double hours = std::chrono::duration<double>(Clock::now() - start).count() / 3600;
+		return hours > 0 ? done / hours : 0.0;
+	};
+
+	std::vector<std::future<std::string>> results;
+	{
+		AlphaYa::ThreadPool pool(thread_count);
+		out << "Analyzing " << positions.size() << " positions with " << pool.threads.size() << " threads" << std::endl;
+		for (const std::string &position : positions)
+		{
+			std::shared_ptr<std::promise<std::string>> result = std::make_shared<std::promise<std::string>>();
+			results.push_back(result->get_future());
+			pool.submit(std::bind(analyze, position, config, simulate_count, move_time, top, result));
+		}
+		for (IndexType i = 0; i < results.size(); ++i)
+		{
+			result_out << results[i].get() << std::flush;
+			if (!output_path.empty() && Clock::now() - last_report >= std::chrono::seconds(10))
+			{
+				last_report = Clock::now();
+				out << i + 1 << "/" << positions.size() << " positions, " << speed(i + 1) << " positions/hour" << std::endl;
+			}
+		}
+	}
+	const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	out << "Analyzed " << positions.size() << " positions in " << seconds << " s, " << speed(positions.size()) << " positions/hour" << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,264 @@
+#ifdef GAME_TIC_TAC_TOE
+#include "../mygames/tictactoe/export.hpp"
+#endif
+#ifdef GAME_GOMOKU
+#include "../mygames/gomoku/export.hpp"
+#endif
+
+#include "perf_counter.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+Tree compaction benchmark: play a game with two "ai" agents of the same configuration and seed,
+the first without compaction and the second with compaction, and compare their searches move by move
+Usage: bench [moves N] [scount N] [config CONFIG]
+config must be the last argument, since the agent config may contain spaces.
+Both agents search every position of the game, which continues with the action of the first agent,
+so they reuse their trees between moves. Compaction does not change the search, so the actions must agree.
+For every move, the search time of both agents, the compaction time, the last level cache misses of the searches
+(n/a where hardware counters are unavailable), and the locality of both trees before the search are written.
+Locality is the mean number of distinct cache lines and 4096 byte pages touched by a descent from the root
+along paths chosen by visits, which compaction lowers by placing the nodes of the paths next to each other.
+*/
+
+using AlphaYaExport::Action;
+using AlphaYaExport::Agent;
+using AlphaYaExport::IndexType;
+using AlphaYaExport::MCTSAgent;
+using AlphaYaExport::PerfCounter;
+using AlphaYaExport::ScoreType;
+using AlphaYaExport::State;
+
+using AlphaYaExport::mcts_agent;
+using AlphaYaExport::players;
+
+typedef MCTSAgent::Node Node;
+
+constexpr std::uintptr_t cache_line = 64, page_size = 4096;
+constexpr IndexType descent_count = 1000;
+
+/*
+Add the cache lines of the bytes [begin, begin + size) into lines
+*/
+void touch(const void *begin, std::size_t size, std::vector<std::uintptr_t> &lines)
+{
+	if (!size)
+	{
+		return;
+	}
+	const std::uintptr_t first = (std::uintptr_t)begin / cache_line, last = ((std::uintptr_t)begin + size - 1) / cache_line;
+	for (std::uintptr_t line = first; line <= last; ++line)
+	{
+		lines.push_back(line);
+	}
+}
+
+/*
+Average the distinct cache lines and pages touched by descent_count descents from root into lines and pages
+A descent chooses every child with probability proportional to its visits, and touches the node,
+its selection statistics and the entry of the chosen child at every step.
+random is seeded the same for both agents, whose trees have the same shape, so that they descend the same paths.
+*/
+void locality(const std::shared_ptr<Node> &root, double &lines, double &pages)
+{
+	lines = pages = 0;
+	if (!root)
+	{
+		return;
+	}
+	std::mt19937 random(0);
+	std::vector<std::uintptr_t> touched;
+	for (IndexType k = 0; k < descent_count; ++k)
+	{
+		touched.clear();
+		for (const Node *node = root.get();;)
+		{
+			touch(node, sizeof(Node), touched);
+			touch(node->stats.data(), node->stats.size() * sizeof(node->stats[0]), touched);
+			ScoreType total = 0;
+			for (const Node::Child &child : node->children)
+			{
+				total += child.node->count;
+			}
+			if (total <= 0)
+			{
+				break;
+			}
+			ScoreType target = std::uniform_int_distribution<ScoreType>(0, total - 1)(random);
+			IndexType index = 0;
+			while (target >= node->children[index].node->count)
+			{
+				target -= node->children[index++].node->count;
+			}
+			touch(&node->children[index], sizeof(Node::Child), touched);
+			node = node->children[index].node.get();
+		}
+		std::sort(touched.begin(), touched.end());
+		touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+		lines += touched.size();
+		for (std::size_t i = 0; i < touched.size(); ++i)
+		{
+			if (!i || touched[i] / (page_size / cache_line) != touched[i - 1] / (page_size / cache_line))
+			{
+				++pages;
+			}
+		}
+	}
+	lines /= descent_count;
+	pages /= descent_count;
+}
+
+int main(int argc, char *argv[])
+{
+	std::ostream &out = std::cout;
+
+	std::string arguments;
+	for (int i = 1; i < argc; ++i)
+	{
+		arguments += argv[i];
+		arguments += " ";
+	}
+
+	IndexType move_count = 20;
+	IndexType simulate_count = 0;
+	std::string config;
+	std::string argument;
+	for (std::istringstream cfin(arguments);;)
+	{
+		cfin >> argument;
+		if (cfin.fail())
+		{
+			break;
+		}
+		if (argument == "moves")
+		{
+			cfin >> move_count;
+			continue;
+		}
+		if (argument == "scount")
+		{
+			cfin >> simulate_count;
+			continue;
+		}
+		if (argument == "config")
+		{
+			cfin >> std::ws;
+			std::getline(cfin, config);
+			config.erase(config.find_last_not_of(' ') + 1);
+			break;
+		}
+		out << "Unknown argument: " << argument << std::endl;
+		return 1;
+	}
+
+	std::unique_ptr<Agent> agents[2] = {mcts_agent(config), mcts_agent(config)};
+	MCTSAgent *mcts[2];
+	for (IndexType k = 0; k < 2; ++k)
+	{
+		mcts[k] = dynamic_cast<MCTSAgent *>(agents[k].get());
+		if (!mcts[k])
+		{
+			out << "The agent of config is not an MCTS agent" << std::endl;
+			return 1;
+		}
+		if (simulate_count)
+		{
+			mcts[k]->simulate_count = simulate_count;
+		}
+		mcts[k]->ponder = false;
+		mcts[k]->compaction = k;
+	}
+
+	PerfCounter misses(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+	typedef std::chrono::steady_clock Clock;
+	const auto milliseconds = [](Clock::duration duration)
+	{
+		return std::chrono::duration<double, std::milli>(duration).count();
+	};
+
+	out << std::fixed << std::setprecision(2)
+		<< std::setw(6) << "move" << std::setw(8) << "action" << std::setw(12) << "off ms" << std::setw(12) << "on ms" << std::setw(12) << "compact ms"
+		<< std::setw(14) << "off misses" << std::setw(14) << "on misses" << std::setw(12) << "off lines" << std::setw(12) << "on lines" << std::setw(12) << "off pages" << std::setw(12) << "on pages" << std::endl;
+	State state;
+	state.init("");
+	ScoreType scores[players];
+	double totals[3] = {0, 0, 0};
+	std::uint64_t total_misses[2] = {0, 0};
+	IndexType moves = 0, disagreements = 0;
+	for (; moves < move_count && !state.calculateScore(scores); ++moves)
+	{
+		Action actions[2];
+		double times[2], lines[2], pages[2];
+		std::uint64_t counts[2];
+		double compact_time = 0;
+		for (IndexType k = 0; k < 2; ++k)
+		{
+			std::istringstream in;
+			std::ostringstream log;
+			// The subtrees of other actions are freed before timing, and the reused tree is compacted before searching
+			if (mcts[k]->root)
+			{
+				mcts[k]->root = MCTSAgent::find_state(mcts[k]->root, state);
+			}
+			if (k && mcts[k]->root)
+			{
+				const Clock::time_point start = Clock::now();
+				mcts[k]->memory = mcts[k]->tree_memory(mcts[k]->root);
+				mcts[k]->compact();
+				compact_time = milliseconds(Clock::now() - start);
+			}
+			locality(mcts[k]->root, lines[k], pages[k]);
+			const Clock::time_point start = Clock::now();
+			misses.start();
+			actions[k] = mcts[k]->move(state, in, log);
+			counts[k] = misses.stop();
+			times[k] = milliseconds(Clock::now() - start);
+			total_misses[k] += counts[k];
+			totals[k] += times[k];
+		}
+		totals[2] += compact_time;
+		std::ostringstream sout;
+		actions[0].output(sout);
+		if (!(actions[0] == actions[1]))
+		{
+			++disagreements;
+			sout << "!";
+		}
+		out << std::setw(6) << moves + 1 << std::setw(8) << sout.str() << std::setw(12) << times[0] << std::setw(12) << times[1] << std::setw(12) << compact_time;
+		for (IndexType k = 0; k < 2; ++k)
+		{
+			if (misses.valid())
+			{
+				out << std::setw(14) << counts[k];
+			}
+			else
+			{
+				out << std::setw(14) << "n/a";
+			}
+		}
+		out << std::setw(12) << lines[0] << std::setw(12) << lines[1] << std::setw(12) << pages[0] << std::setw(12) << pages[1] << std::endl;
+		state.move(actions[0]);
+	}
+	out << "Total over " << moves << " moves: off " << totals[0] << " ms, on " << totals[1] << " ms + compaction " << totals[2] << " ms";
+	if (misses.valid())
+	{
+		out << ", cache misses off " << total_misses[0] << ", on " << total_misses[1];
+	}
+	else
+	{
+		out << ", hardware counters unavailable";
+	}
+	out << ", " << disagreements << " disagreements" << std::endl;
+	return disagreements ? 1 : 0;
+}
\ No newline at end of file
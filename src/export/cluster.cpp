@@ -0,0 +1,453 @@
+#ifdef GAME_TIC_TAC_TOE
+#include "../mygames/tictactoe/export.hpp"
+#endif
+#ifdef GAME_GOMOKU
+#include "../mygames/gomoku/export.hpp"
+#endif
+
+#include "socket.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+
+/*
+Distributed root parallel search: worker processes search the same position with MCTSAgent and different seeds,
+and the leader merges the statistics of their root children to pick the move
+Usage: cluster mode leader address ADDRESS workers N [scount N] [time MS] [interval MS] [seed N]
+       cluster mode worker address ADDRESS [config CONFIG]
+config must be the last argument, since the agent config may contain spaces, and its seed is replaced.
+ADDRESS is tcp:HOST:PORT, unix:PATH or a path of a Unix domain socket.
+The leader waits for workers connections, then reads one state string per line from standard input
+(an empty line for default_state), and replies with the merged best move and the cost of synchronization.
+Every worker searches with scount simulations or for time milliseconds, as in analyze,
+and sends the statistics of all visited root children every interval milliseconds and at the end.
+The leader does not search, and picks the action with the most visits summed over workers.
+
+Protocol (leader to worker lines, worker to leader lines with binary payloads):
+hello ID SEED                         sent once after connecting
+ping                                  replied with "pong MICROSECONDS" of the steady clock of the worker
+go SCOUNT TIME INTERVAL STATE         search STATE
+stats FINAL SIMULATIONS MICROSECONDS BYTES, followed by BYTES bytes of root children statistics
+quit
+The leader estimates the clock offset of every worker from pings, so that the latency of every statistics message
+is the time from sending it to merging it, measured across machines.
+Only POSIX systems are supported.
+*/
+
+using AlphaYaExport::Action;
+using AlphaYaExport::Agent;
+using AlphaYaExport::Connection;
+using AlphaYaExport::IndexType;
+using AlphaYaExport::MCTSAgent;
+using AlphaYaExport::ScoreType;
+using AlphaYaExport::State;
+using AlphaYaExport::StopToken;
+
+using AlphaYaExport::default_state;
+using AlphaYaExport::mcts_agent;
+using AlphaYaExport::players;
+
+static_assert(State::action_count <= 65536, "action indices should fit in 16 bits");
+
+/*
+Statistics of a root child, as 10 bytes on the wire:
+16-bit action index, 32-bit visits and 32-bit sum of scores for the player to move at the root
+*/
+class ChildStats
+{
+public:
+	std::uint16_t action;
+	std::uint32_t count;
+	std::int32_t score;
+};
+constexpr IndexType child_stats_bytes = 10;
+
+std::int64_t micros()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::string encode_stats(const MCTSAgent::Node &root)
+{
+	const IndexType player = root.state.toMove();
+	std::string data;
+	for (const MCTSAgent::Node::Child &child : root.children)
+	{
+		if (!child.node->count)
+		{
+			continue;
+		}
+		// Final nodes keep the result of one visit instead of the sum
+		const ScoreType score = child.node->is_final ? child.node->scores[player] * child.node->count : child.node->scores[player];
+		const ChildStats stats{(std::uint16_t)child.action.index(), (std::uint32_t)child.node->count, (std::int32_t)score};
+		char bytes[child_stats_bytes];
+		std::memcpy(bytes, &stats.action, 2);
+		std::memcpy(bytes + 2, &stats.count, 4);
+		std::memcpy(bytes + 6, &stats.score, 4);
+		data.append(bytes, child_stats_bytes);
+	}
+	return data;
+}
+
+std::vector<ChildStats> decode_stats(const std::string &data)
+{
+	std::vector<ChildStats> result(data.size() / child_stats_bytes);
+	for (IndexType i = 0; i < result.size(); ++i)
+	{
+		const char *bytes = data.data() + i * child_stats_bytes;
+		std::memcpy(&result[i].action, bytes, 2);
+		std::memcpy(&result[i].count, bytes + 2, 4);
+		std::memcpy(&result[i].score, bytes + 6, 4);
+	}
+	return result;
+}
+
+int worker(std::ostream &out, const std::string &address, const std::string &config)
+{
+	const int fd = AlphaYaExport::connect_address(address);
+	if (fd < 0)
+	{
+		out << "Cannot connect to " << address << std::endl;
+		return 1;
+	}
+	Connection connection(fd);
+	std::unique_ptr<Agent> agent;
+	MCTSAgent *mcts = nullptr;
+	IndexType id = 0;
+	for (std::string line; connection.read_line(line);)
+	{
+		std::istringstream lin(line);
+		std::string command;
+		lin >> command;
+		if (command == "hello")
+		{
+			std::uint64_t seed;
+			lin >> id >> seed;
+			agent = mcts_agent(config + " seed " + std::to_string(seed));
+			mcts = dynamic_cast<MCTSAgent *>(agent.get());
+			if (!mcts)
+			{
+				out << "The agent of config is not MCTSAgent" << std::endl;
+				return 1;
+			}
+			mcts->ponder = false;
+			out << "Worker " << id << " connected to " << address << std::endl;
+			continue;
+		}
+		if (command == "ping")
+		{
+			connection.write_line("pong " + std::to_string(micros()));
+			continue;
+		}
+		if (command == "go" && mcts)
+		{
+			IndexType simulate_count, move_time, interval;
+			std::string state_string;
+			lin >> simulate_count >> move_time >> interval >> std::ws;
+			std::getline(lin, state_string);
+			State state;
+			state.init(state_string);
+			const auto send = [&](bool final, IndexType simulations)
+			{
+				const std::string data = encode_stats(*mcts->root);
+				std::ostringstream sout;
+				sout << "stats " << final << " " << simulations << " " << micros() << " " << data.size() << "\n";
+				return connection.write(sout.str() + data);
+			};
+			ScoreType scores[players];
+			if (state.calculateScore(scores))
+			{
+				connection.write_line("stats 1 0 " + std::to_string(micros()) + " 0");
+				continue;
+			}
+			mcts->set_budget(simulate_count, move_time);
+			std::int64_t last = micros();
+			IndexType simulations = 0;
+			const MCTSAgent::Progress progress = [&](IndexType i, const Action &best, float value)
+			{
+				simulations = i;
+				if (interval && !(i & 63) && micros() - last >= (std::int64_t)interval * 1000)
+				{
+					last = micros();
+					send(false, i);
+				}
+			};
+			std::istringstream in;
+			std::ostringstream log;
+			mcts->search(state, in, log, StopToken(), progress);
+			if (!send(true, simulations))
+			{
+				break;
+			}
+			continue;
+		}
+		if (command == "quit")
+		{
+			break;
+		}
+	}
+	out << "Worker " << id << " disconnected" << std::endl;
+	return 0;
+}
+
+/*
+Connection of the leader to a worker
+offset is the clock of the worker minus the clock of the leader in microseconds,
+and stats is the latest statistics of the current search.
+*/
+class Worker
+{
+public:
+	std::unique_ptr<Connection> connection;
+	std::int64_t offset, rtt;
+	std::vector<ChildStats> stats;
+	IndexType simulations;
+};
+
+int leader(std::ostream &out, const std::string &address, IndexType worker_count, IndexType simulate_count, IndexType move_time, IndexType interval, std::uint64_t seed)
+{
+	const int listen_fd = AlphaYaExport::listen_address(address);
+	if (listen_fd < 0)
+	{
+		out << "Cannot listen on " << address << std::endl;
+		return 1;
+	}
+	out << "Waiting for " << worker_count << " workers on " << address << std::endl;
+	std::vector<Worker> workers(worker_count);
+	for (IndexType k = 0; k < worker_count; ++k)
+	{
+		const int fd = ::accept(listen_fd, nullptr, nullptr);
+		if (fd < 0)
+		{
+			--k;
+			continue;
+		}
+		const int on = 1;
+		::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+		Worker &w = workers[k];
+		w.connection = std::make_unique<Connection>(fd);
+		w.connection->write_line("hello " + std::to_string(k) + " " + std::to_string(seed + k));
+		// Keep the ping with the smallest round trip, whose offset is the most accurate
+		w.rtt = std::numeric_limits<std::int64_t>::max();
+		for (IndexType i = 0; i < 8; ++i)
+		{
+			const std::int64_t t0 = micros();
+			std::string line, word;
+			std::int64_t t;
+			w.connection->write_line("ping");
+			if (!w.connection->read_line(line) || !(std::istringstream(line) >> word >> t))
+			{
+				out << "Worker " << k << " failed" << std::endl;
+				return 1;
+			}
+			const std::int64_t t1 = micros();
+			if (t1 - t0 < w.rtt)
+			{
+				w.rtt = t1 - t0;
+				w.offset = t - (t0 + t1) / 2;
+			}
+		}
+		out << "Worker " << k << " connected, round trip " << w.rtt << " us" << std::endl;
+	}
+	::close(listen_fd);
+
+	for (std::string line; std::getline(std::cin, line);)
+	{
+		if (!line.empty() && line.back() == '\r')
+		{
+			line.pop_back();
+		}
+		State state;
+		state.init(line.empty() ? default_state : line);
+		std::ostringstream sout;
+		state.output(sout, "");
+		std::ostringstream go;
+		go << "go " << simulate_count << " " << move_time << " " << interval << " " << sout.str();
+
+		std::mutex mutex;
+		IndexType messages = 0, bytes = 0;
+		std::int64_t latency_sum = 0, latency_max = 0;
+		bool failed = false;
+		const std::int64_t start = micros();
+		const auto receive = [&](Worker &w)
+		{
+			w.stats.clear();
+			w.simulations = 0;
+			if (!w.connection->write_line(go.str()))
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				failed = true;
+				return;
+			}
+			for (bool final = false; !final;)
+			{
+				std::string header, word, data;
+				IndexType simulations, size;
+				std::int64_t sent;
+				if (!w.connection->read_line(header) || !(std::istringstream(header) >> word >> final >> simulations >> sent >> size) || !w.connection->read_bytes(data, size))
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					failed = true;
+					return;
+				}
+				std::vector<ChildStats> stats = decode_stats(data);
+				std::lock_guard<std::mutex> lock(mutex);
+				w.stats.swap(stats);
+				w.simulations = simulations;
+				const std::int64_t latency = std::max(micros() - (sent - w.offset), (std::int64_t)0);
+				++messages;
+				bytes += header.size() + 1 + size;
+				latency_sum += latency;
+				latency_max = std::max(latency_max, latency);
+			}
+		};
+		std::vector<std::thread> threads;
+		for (Worker &w : workers)
+		{
+			threads.emplace_back(receive, std::ref(w));
+		}
+		for (std::thread &thread : threads)
+		{
+			thread.join();
+		}
+		if (failed)
+		{
+			out << "A worker failed" << std::endl;
+			return 1;
+		}
+		const double seconds = (micros() - start) * 1e-6;
+
+		std::vector<std::uint64_t> counts(State::action_count, 0);
+		std::vector<std::int64_t> scores(State::action_count, 0);
+		IndexType simulations = 0;
+		for (const Worker &w : workers)
+		{
+			simulations += w.simulations;
+			for (const ChildStats &stats : w.stats)
+			{
+				counts[stats.action] += stats.count;
+				scores[stats.action] += stats.score;
+			}
+		}
+		const IndexType best = std::max_element(counts.begin(), counts.end()) - counts.begin();
+		if (!counts[best])
+		{
+			out << "bestmove -" << std::endl;
+			continue;
+		}
+		out << "bestmove ";
+		Action::fromIndex(best).output(out);
+		out << " value " << (double)scores[best] / counts[best] << " visits " << counts[best]
+			<< " simulations " << simulations << " time " << seconds << " s" << std::endl;
+		out << std::fixed << std::setprecision(3)
+			<< "sync " << messages << " messages, " << (messages ? bytes / messages : 0) << " bytes per message, "
+			<< "latency mean " << (messages ? latency_sum * 1e-3 / messages : 0.0) << " ms, max " << latency_max * 1e-3 << " ms" << std::endl;
+		out.unsetf(std::ios::floatfield);
+		out << std::setprecision(6);
+	}
+	for (Worker &w : workers)
+	{
+		w.connection->write_line("quit");
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	std::ostream &out = std::cout;
+
+	std::string arguments;
+	for (int i = 1; i < argc; ++i)
+	{
+		arguments += argv[i];
+		arguments += " ";
+	}
+
+	std::string mode;
+	std::string address = "alphaya_cluster.sock";
+	IndexType worker_count = 1;
+	IndexType simulate_count = 0;
+	IndexType move_time = 0;
+	IndexType interval = 100;
+	std::uint64_t seed = 42;
+	std::string config;
+	std::string argument;
+	for (std::istringstream cfin(arguments);;)
+	{
+		cfin >> argument;
+		if (cfin.fail())
+		{
+			break;
+		}
+		if (argument == "mode")
+		{
+			cfin >> mode;
+			continue;
+		}
+		if (argument == "address")
+		{
+			cfin >> address;
+			continue;
+		}
+		if (argument == "workers")
+		{
+			cfin >> worker_count;
+			continue;
+		}
+		if (argument == "scount")
+		{
+			cfin >> simulate_count;
+			continue;
+		}
+		if (argument == "time")
+		{
+			cfin >> move_time;
+			continue;
+		}
+		if (argument == "interval")
+		{
+			cfin >> interval;
+			continue;
+		}
+		if (argument == "seed")
+		{
+			cfin >> seed;
+			continue;
+		}
+		if (argument == "config")
+		{
+			cfin >> std::ws;
+			std::getline(cfin, config);
+			break;
+		}
+		out << "Unknown argument: " << argument << std::endl;
+		return 1;
+	}
+	if (mode == "leader")
+	{
+		if (!simulate_count && !move_time)
+		{
+			simulate_count = 10000;
+		}
+		return leader(out, address, worker_count, simulate_count, move_time, interval, seed);
+	}
+	if (mode == "worker")
+	{
+		return worker(out, address, config);
+	}
+	out << "Unknown mode: " << mode << std::endl;
+	return 1;
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+/*
+Minimal hardware event counter over Linux perf_event_open
+Counting may be unavailable, for example in virtual machines or with a restrictive perf_event_paranoid,
+in which case the counter is invalid and reads nothing. Only Linux is supported.
+*/
+
+#include <cstdint>
+#include <cstring>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace AlphaYaExport
+{
+	class PerfCounter
+	{
+	public:
+		int fd;
+
+		/*
+		Counter of the event type and config for the calling thread in user space, see man perf_event_open
+		*/
+		PerfCounter(std::uint32_t type, std::uint64_t config) : fd(-1)
+		{
+			perf_event_attr attributes;
+			std::memset(&attributes, 0, sizeof(attributes));
+			attributes.size = sizeof(attributes);
+			attributes.type = type;
+			attributes.config = config;
+			attributes.disabled = 1;
+			attributes.exclude_kernel = 1;
+			attributes.exclude_hv = 1;
+			fd = (int)::syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+		}
+
+		PerfCounter(const PerfCounter &) = delete;
+		PerfCounter &operator=(const PerfCounter &) = delete;
+
+		~PerfCounter()
+		{
+			if (fd >= 0)
+			{
+				::close(fd);
+			}
+		}
+
+		bool valid() const
+		{
+			return fd >= 0;
+		}
+
+		void start()
+		{
+			if (fd >= 0)
+			{
+				::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+				::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+			}
+		}
+
+		/*
+		Stop counting and returns the count since start, 0 if invalid
+		*/
+		std::uint64_t stop()
+		{
+			std::uint64_t count = 0;
+			if (fd >= 0)
+			{
+				::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+				if (::read(fd, &count, sizeof(count)) != sizeof(count))
+				{
+					count = 0;
+				}
+			}
+			return count;
+		}
+	};
+};
\ No newline at end of file
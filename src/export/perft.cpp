@@ -0,0 +1,133 @@
+#ifdef GAME_TIC_TAC_TOE
+#include "../mygames/tictactoe/export.hpp"
+#endif
+#ifdef GAME_GOMOKU
+#include "../mygames/gomoku/export.hpp"
+#endif
+
+#include "../game/perft.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/*
+Perft tool: count leaf positions to a fixed depth, and report nodes per second
+Usage: perft [depth N] [threads N] [hash MB] [divide] [state STATE_STRING]
+state must be the last argument, since the state string may contain spaces.
+*/
+int main(int argc, char *argv[])
+{
+	using AlphaYaExport::Action;
+	using AlphaYaExport::IndexType;
+	using AlphaYaExport::State;
+
+	using AlphaYaExport::default_state;
+	using AlphaYaExport::perft_results;
+
+	typedef AlphaYa::Perft<State> Perft;
+
+	std::ostream &out = std::cout;
+
+	std::string config;
+	for (int i = 1; i < argc; ++i)
+	{
+		config += argv[i];
+		config += " ";
+	}
+
+	IndexType depth = 3;
+	IndexType thread_count = std::thread::hardware_concurrency();
+	std::uint64_t hash_megabytes = 0;
+	bool divide = false;
+	std::string state_string = default_state;
+	std::string argument;
+	for (std::istringstream cfin(config);;)
+	{
+		cfin >> argument;
+		if (cfin.fail())
+		{
+			break;
+		}
+		if (argument == "depth")
+		{
+			cfin >> depth;
+			continue;
+		}
+		if (argument == "threads")
+		{
+			cfin >> thread_count;
+			continue;
+		}
+		if (argument == "hash")
+		{
+			cfin >> hash_megabytes;
+			continue;
+		}
+		if (argument == "divide")
+		{
+			divide = true;
+			continue;
+		}
+		if (argument == "state")
+		{
+			std::getline(cfin, state_string);
+			break;
+		}
+		out << "Unknown argument: " << argument << std::endl;
+		return 1;
+	}
+	if (!thread_count)
+	{
+		thread_count = 1;
+	}
+
+	State state;
+	state.init(state_string);
+	out << "State: ";
+	state.output(out, "");
+	out << std::endl;
+	out << "Depth: " << depth << std::endl;
+	out << "Threads: " << thread_count << std::endl;
+	out << "Hash: " << hash_megabytes << " MB" << std::endl;
+
+	Perft perft(hash_megabytes << 20);
+	std::vector<std::pair<Action, Perft::CountType>> results;
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	const Perft::CountType nodes = perft.count(state, depth, thread_count, results);
+	const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	const double seconds = std::chrono::duration<double>(end - start).count();
+
+	if (divide)
+	{
+		for (const std::pair<Action, Perft::CountType> &result : results)
+		{
+			result.first.output(out);
+			out << ": " << result.second << std::endl;
+		}
+	}
+	out << "Nodes: " << nodes << std::endl;
+	out << "Time: " << seconds << " s" << std::endl;
+	out << "Speed: " << (std::uint64_t)(nodes / (seconds > 0.0 ? seconds : 1e-9)) << " nodes/s" << std::endl;
+
+	State expected_state;
+	expected_state.init(default_state);
+	std::ostringstream state_out, expected_out;
+	state.output(state_out, "");
+	expected_state.output(expected_out, "");
+	if (depth < perft_results.size() && state_out.str() == expected_out.str())
+	{
+		if (nodes != perft_results[depth])
+		{
+			out << "MISMATCH: expected " << perft_results[depth] << std::endl;
+			return 1;
+		}
+		out << "OK" << std::endl;
+	}
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,349 @@
+#ifdef GAME_TIC_TAC_TOE
+#include "../mygames/tictactoe/export.hpp"
+#endif
+#ifdef GAME_GOMOKU
+#include "../mygames/gomoku/export.hpp"
+#endif
+
+#include "shared_ring.hpp"
+
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*
+Self-play farm: worker processes play games between two "ai" agents, and the coordinator collects them into one record file
+Usage: selfplay [workers N] [games N] [output PATH] [interval SECONDS] [config CONFIG]
+config must be the last argument, since the agent config may contain spaces, and its seed is replaced for every game.
+games 0 (the default) plays until interrupted. Games are appended to PATH in the record format of terminal.
+Every worker sends finished games through its own shared memory ring, and crashed workers are restarted.
+Every interval seconds, a dashboard line reports games per minute and positions per second.
+Only POSIX systems are supported.
+*/
+
+using AlphaYaExport::Action;
+using AlphaYaExport::Agent;
+using AlphaYaExport::IndexType;
+using AlphaYaExport::ScoreType;
+using AlphaYaExport::State;
+
+using AlphaYaExport::default_state;
+using AlphaYaExport::mcts_agent;
+using AlphaYaExport::players;
+using AlphaYaExport::record_prefix;
+
+/*
+A finished game, as indices of the actions played from default_state
+Games longer than max_game_length are dropped.
+*/
+constexpr IndexType max_game_length = State::action_count;
+static_assert(State::action_count <= 65536, "action indices should fit in 16 bits");
+
+class GameSlot
+{
+public:
+	std::uint32_t worker, length;
+	std::uint32_t seeds[players];
+	ScoreType scores[players];
+	std::uint16_t actions[max_game_length];
+};
+
+typedef AlphaYaExport::SharedRing<GameSlot, 64> Ring;
+
+volatile std::sig_atomic_t stop = 0;
+
+void handle_stop(int)
+{
+	stop = 1;
+}
+
+std::string agent_config(const std::string &config, std::uint32_t seed)
+{
+	std::ostringstream sout;
+	sout << config << " seed " << seed;
+	return sout.str();
+}
+
+/*
+Worker process: play games forever, and push them into ring
+Seeds are different for every worker, restart and game.
+*/
+void work(Ring &ring, IndexType worker, IndexType generation, const std::string &config)
+{
+	std::ostream null_out(nullptr);
+	std::istringstream in;
+	for (std::uint32_t game = 0;; ++game)
+	{
+		GameSlot slot;
+		slot.worker = (std::uint32_t)worker;
+		slot.length = 0;
+		std::unique_ptr<Agent> agents[players];
+		for (IndexType player = 0; player < players; ++player)
+		{
+			slot.seeds[player] = (std::uint32_t)(((worker * 1009 + generation) * 1000003 + game) * players + player);
+			agents[player] = mcts_agent(agent_config(config, slot.seeds[player]));
+		}
+		State state;
+		state.init(default_state);
+		bool too_long = false;
+		while (!state.calculateScore(slot.scores))
+		{
+			if (slot.length == max_game_length)
+			{
+				too_long = true;
+				break;
+			}
+			const Action action = agents[state.toMove()]->move(state, in, null_out);
+			state.move(action);
+			slot.actions[slot.length++] = (std::uint16_t)action.index();
+		}
+		if (too_long)
+		{
+			continue;
+		}
+		while (!ring.push(slot))
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	}
+}
+
+pid_t start_worker(Ring *rings, IndexType worker, IndexType generation, const std::string &config)
+{
+	std::cout.flush();
+	const pid_t pid = ::fork();
+	if (!pid)
+	{
+		// The coordinator stops workers, so that an interrupt is not mistaken for a crash
+		::signal(SIGINT, SIG_IGN);
+		::signal(SIGTERM, SIG_DFL);
+		work(rings[worker], worker, generation, config);
+		::_exit(0);
+	}
+	return pid;
+}
+
+/*
+Write a game in the record format of terminal
+*/
+void write_record(std::ostream &fout, const GameSlot &slot, const std::string &config)
+{
+	fout << "GAME\n";
+	fout << record_prefix << "\n";
+	fout << "PLAYERS\n";
+	fout << players << "\n";
+	for (IndexType player = 0; player < players; ++player)
+	{
+		fout << "PLAYER\n";
+		fout << player << "\n";
+		fout << "ai\n";
+		fout << agent_config(config, slot.seeds[player]) << "\n";
+	}
+	State state;
+	state.init(default_state);
+	fout << "INIT\n";
+	state.output(fout, "");
+	fout << "\n";
+	for (IndexType step = 0; step < slot.length; ++step)
+	{
+		const IndexType player = state.toMove();
+		const Action action = Action::fromIndex(slot.actions[step]);
+		state.move(action);
+		fout << "STEP\n";
+		fout << player << "\n";
+		action.output(fout);
+		fout << "\n";
+		state.output(fout, "");
+		fout << "\n";
+	}
+	fout << "SCORE\n";
+	for (IndexType player = 0; player < players; ++player)
+	{
+		fout << slot.scores[player] << "\n";
+	}
+	fout.flush();
+}
+
+int main(int argc, char *argv[])
+{
+	std::ostream &out = std::cout;
+
+	std::string arguments;
+	for (int i = 1; i < argc; ++i)
+	{
+		arguments += argv[i];
+		arguments += " ";
+	}
+
+	IndexType worker_count = std::thread::hardware_concurrency();
+	IndexType game_limit = 0;
+	std::string path = "records/selfplay.txt";
+	IndexType interval = 10;
+	std::string config;
+	std::string argument;
+	for (std::istringstream cfin(arguments);;)
+	{
+		cfin >> argument;
+		if (cfin.fail())
+		{
+			break;
+		}
+		if (argument == "workers")
+		{
+			cfin >> worker_count;
+			continue;
+		}
+		if (argument == "games")
+		{
+			cfin >> game_limit;
+			continue;
+		}
+		if (argument == "output")
+		{
+			cfin >> path;
+			continue;
+		}
+		if (argument == "interval")
+		{
+			cfin >> interval;
+			continue;
+		}
+		if (argument == "config")
+		{
+			cfin >> std::ws;
+			std::getline(cfin, config);
+			break;
+		}
+		out << "Unknown argument: " << argument << std::endl;
+		return 1;
+	}
+	if (!worker_count)
+	{
+		worker_count = 1;
+	}
+	if (!interval)
+	{
+		interval = 1;
+	}
+
+	std::ofstream fout(path, std::ios::app);
+	if (fout.fail())
+	{
+		out << "Cannot open " << path << std::endl;
+		return 1;
+	}
+	Ring *rings = Ring::create(worker_count);
+	if (!rings)
+	{
+		out << "Cannot create shared memory" << std::endl;
+		return 1;
+	}
+
+	std::vector<pid_t> pids(worker_count);
+	std::vector<IndexType> generations(worker_count, 0);
+	for (IndexType worker = 0; worker < worker_count; ++worker)
+	{
+		pids[worker] = start_worker(rings, worker, 0, config);
+	}
+	::signal(SIGINT, handle_stop);
+	::signal(SIGTERM, handle_stop);
+	out << "Started " << worker_count << " workers, writing games to " << path << std::endl;
+
+	typedef std::chrono::steady_clock Clock;
+	const Clock::time_point start = Clock::now();
+	Clock::time_point last_report = start;
+	IndexType games = 0, positions = 0, restarts = 0;
+	IndexType last_games = 0, last_positions = 0;
+	const auto collect = [&]() -> bool
+	{
+		bool collected = false;
+		GameSlot slot;
+		for (IndexType worker = 0; worker < worker_count; ++worker)
+		{
+			while ((!game_limit || games < game_limit) && rings[worker].pop(slot))
+			{
+				write_record(fout, slot, config);
+				++games;
+				positions += slot.length;
+				collected = true;
+			}
+		}
+		return collected;
+	};
+	const auto report = [&](Clock::time_point now)
+	{
+		const double seconds = std::chrono::duration<double>(now - last_report).count();
+		out << std::fixed << std::setprecision(1)
+			<< "[" << std::chrono::duration<double>(now - start).count() << "s] "
+			<< "games " << games
+			<< " | " << (games - last_games) * 60 / seconds << " games/min"
+			<< " | " << (positions - last_positions) / seconds << " positions/s"
+			<< " | workers " << worker_count
+			<< " | restarts " << restarts << std::endl;
+		last_report = now;
+		last_games = games;
+		last_positions = positions;
+	};
+
+	while (!stop && (!game_limit || games < game_limit))
+	{
+		const bool collected = collect();
+		int status;
+		for (pid_t pid; (pid = ::waitpid(-1, &status, WNOHANG)) > 0;)
+		{
+			for (IndexType worker = 0; worker < worker_count; ++worker)
+			{
+				if (pids[worker] == pid)
+				{
+					out << "Worker " << worker << " ";
+					if (WIFSIGNALED(status))
+					{
+						out << "killed by signal " << WTERMSIG(status);
+					}
+					else
+					{
+						out << "exited with status " << WEXITSTATUS(status);
+					}
+					out << ", restarting" << std::endl;
+					++restarts;
+					pids[worker] = start_worker(rings, worker, ++generations[worker], config);
+				}
+			}
+		}
+		const Clock::time_point now = Clock::now();
+		if (now - last_report >= std::chrono::seconds(interval))
+		{
+			report(now);
+		}
+		if (!collected)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	}
+
+	for (pid_t pid : pids)
+	{
+		::kill(pid, SIGTERM);
+	}
+	for (pid_t pid : pids)
+	{
+		::waitpid(pid, nullptr, 0);
+	}
+	collect();
+	report(Clock::now());
+	Ring::destroy(rings, worker_count);
+	return 0;
+}
\ No newline at end of file
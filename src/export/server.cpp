@@ -0,0 +1,391 @@
+#ifdef GAME_TIC_TAC_TOE
+#include "../mygames/tictactoe/export.hpp"
+#endif
+#ifdef GAME_GOMOKU
+#include "../mygames/gomoku/export.hpp"
+#endif
+
+#include "../game/thread_pool.hpp"
+#include "socket.hpp"
+
+#include <functional>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/socket.h>
+
+/*
+Engine server: serve many game sessions over a Unix domain socket
+Usage: server [socket PATH] [threads N] [memory MB] [check]
+Each session keeps its own MCTS agent, so the search tree stays warm between requests.
+Searches of all sessions run on one shared thread pool.
+"check" runs the protocol round-trip checks instead of serving, and exits with 1 if any fails.
+
+Protocol (one command per line, every reply ends with "ok", "error ..." or "bestmove ..."):
+new SESSION [CONFIG]       create or replace a session with the "ai" agent config CONFIG
+position SESSION STATE     set the position of SESSION from a state string
+play SESSION ACTION        make a move in SESSION
+go SESSION [SCOUNT]        search with SCOUNT simulations, replies with "info" lines and "bestmove SESSION ACTION"
+show SESSION               replies with "state SESSION STATE"
+delete SESSION             delete a session
+quit                       close the connection
+*/
+
+using AlphaYaExport::Action;
+using AlphaYaExport::Agent;
+using AlphaYaExport::CompactMCTSAgent;
+using AlphaYaExport::IndexType;
+using AlphaYaExport::MCTSAgent;
+using AlphaYaExport::ScoreType;
+using AlphaYaExport::State;
+
+using AlphaYaExport::default_state;
+using AlphaYaExport::mcts_agent;
+using AlphaYaExport::players;
+
+class Session
+{
+public:
+	std::mutex mutex;
+	std::unique_ptr<Agent> agent;
+	State state;
+};
+
+std::mutex sessions_mutex;
+std::unordered_map<std::string, std::shared_ptr<Session>> sessions;
+IndexType session_memory = 1024 << 20;
+
+std::shared_ptr<Session> find_session(const std::string &name)
+{
+	std::lock_guard<std::mutex> lock(sessions_mutex);
+	std::unordered_map<std::string, std::shared_ptr<Session>>::const_iterator it = sessions.find(name);
+	if (it == sessions.end())
+	{
+		return std::shared_ptr<Session>();
+	}
+	return it->second;
+}
+
+/*
+Set the simulation budget of the agent of a session
+*/
+bool set_budget(Agent *agent, IndexType simulate_count)
+{
+	if (MCTSAgent *mcts = dynamic_cast<MCTSAgent *>(agent))
+	{
+		mcts->simulate_count = simulate_count;
+		return true;
+	}
+	if (CompactMCTSAgent *mcts = dynamic_cast<CompactMCTSAgent *>(agent))
+	{
+		mcts->simulate_count = simulate_count;
+		return true;
+	}
+	return false;
+}
+
+/*
+Bound the search tree of a session to session_memory bytes
+MCTSAgent evicts subtrees during the search, and CompactMCTSAgent drops its tree.
+*/
+void limit_memory(Agent *agent)
+{
+	if (MCTSAgent *mcts = dynamic_cast<MCTSAgent *>(agent))
+	{
+		if (!mcts->max_memory || mcts->max_memory > session_memory)
+		{
+			mcts->max_memory = session_memory;
+		}
+		return;
+	}
+	if (CompactMCTSAgent *mcts = dynamic_cast<CompactMCTSAgent *>(agent))
+	{
+		if (mcts->nodes.capacity() * sizeof(CompactMCTSAgent::Node) > session_memory)
+		{
+			std::vector<CompactMCTSAgent::Node>().swap(mcts->nodes);
+		}
+		return;
+	}
+}
+
+/*
+Search job run by the thread pool, the reply is written into result
+*/
+void search(std::shared_ptr<Session> session, const std::string &name, IndexType simulate_count, std::shared_ptr<std::promise<std::string>> result)
+{
+	std::lock_guard<std::mutex> lock(session->mutex);
+	ScoreType scores[players];
+	if (session->state.calculateScore(scores))
+	{
+		result->set_value("error game over\n");
+		return;
+	}
+	if (simulate_count && !set_budget(session->agent.get(), simulate_count))
+	{
+		result->set_value("error agent has no simulation budget\n");
+		return;
+	}
+	limit_memory(session->agent.get());
+	std::istringstream in;
+	std::ostringstream log;
+	const Action action = session->agent->move(session->state, in, log);
+	std::ostringstream sout;
+	std::istringstream lin(log.str());
+	for (std::string line; std::getline(lin, line);)
+	{
+		sout << "info " << name << " " << line << "\n";
+	}
+	sout << "bestmove " << name << " ";
+	action.output(sout);
+	sout << "\n";
+	result->set_value(sout.str());
+}
+
+/*
+Run the command line, the reply is written into reply
+Returns false if the connection should be closed.
+*/
+bool handle(const std::string &line, AlphaYa::ThreadPool &pool, std::string &reply)
+{
+	reply.clear();
+	std::istringstream lin(line);
+	std::string command, name;
+	lin >> command;
+	if (command.empty())
+	{
+		return true;
+	}
+	if (command == "quit")
+	{
+		reply = "ok\n";
+		return false;
+	}
+	lin >> name;
+	if (name.empty())
+	{
+		reply = "error missing session\n";
+		return true;
+	}
+	std::string rest;
+	lin >> std::ws;
+	std::getline(lin, rest);
+
+	if (command == "new")
+	{
+		std::shared_ptr<Session> session = std::make_shared<Session>();
+		session->agent = mcts_agent(rest);
+		session->state.init(default_state);
+		{
+			std::lock_guard<std::mutex> lock(sessions_mutex);
+			sessions[name] = session;
+		}
+		reply = "ok\n";
+		return true;
+	}
+	if (command == "delete")
+	{
+		{
+			std::lock_guard<std::mutex> lock(sessions_mutex);
+			sessions.erase(name);
+		}
+		reply = "ok\n";
+		return true;
+	}
+
+	std::shared_ptr<Session> session = find_session(name);
+	if (!session)
+	{
+		reply = "error unknown session " + name + "\n";
+		return true;
+	}
+
+	if (command == "position")
+	{
+		std::lock_guard<std::mutex> lock(session->mutex);
+		session->state.init(rest);
+		reply = "ok\n";
+		return true;
+	}
+	if (command == "show")
+	{
+		std::ostringstream sout;
+		{
+			std::lock_guard<std::mutex> lock(session->mutex);
+			session->state.output(sout, "");
+		}
+		reply = "state " + name + " " + sout.str() + "\n";
+		return true;
+	}
+	if (command == "play")
+	{
+		std::istringstream rin(rest);
+		std::string input;
+		rin >> input;
+		bool found = false;
+		{
+			std::lock_guard<std::mutex> lock(session->mutex);
+			for (const Action &action : session->state.generateActions())
+			{
+				std::ostringstream aout;
+				action.output(aout);
+				if (aout.str() == input)
+				{
+					session->state.move(action);
+					found = true;
+					break;
+				}
+			}
+		}
+		reply = found ? "ok\n" : "error no such move " + input + "\n";
+		return true;
+	}
+	if (command == "go")
+	{
+		std::istringstream rin(rest);
+		IndexType simulate_count = 0;
+		rin >> simulate_count;
+		std::shared_ptr<std::promise<std::string>> result = std::make_shared<std::promise<std::string>>();
+		std::future<std::string> future = result->get_future();
+		pool.submit(std::bind(search, session, name, simulate_count, result));
+		reply = future.get();
+		return true;
+	}
+	reply = "error unknown command " + command + "\n";
+	return true;
+}
+
+void serve(int fd, AlphaYa::ThreadPool &pool)
+{
+	AlphaYaExport::Connection connection(fd);
+	std::string reply;
+	for (std::string line; connection.read_line(line);)
+	{
+		const bool open = handle(line, pool, reply);
+		if (!reply.empty())
+		{
+			connection.write(reply);
+		}
+		if (!open)
+		{
+			break;
+		}
+	}
+}
+
+/*
+Check that the protocol round-trips positions: "position" of a state followed by "show" returns the same state
+The states are reached by playing the first action from default_state, one more per step.
+Returns the number of failed checks.
+*/
+IndexType check(AlphaYa::ThreadPool &pool, std::ostream &out)
+{
+	IndexType failures = 0;
+	std::string reply;
+	handle("new check", pool, reply);
+	State state;
+	state.init(default_state);
+	for (IndexType step = 0; step < 8; ++step)
+	{
+		ScoreType scores[players];
+		if (state.calculateScore(scores))
+		{
+			break;
+		}
+		const std::vector<Action> actions = state.generateActions();
+		state.move(actions[step % actions.size()]);
+		std::ostringstream sout;
+		state.output(sout, "");
+		handle("position check " + sout.str(), pool, reply);
+		handle("show check", pool, reply);
+		const std::string expected = "state check " + sout.str() + "\n";
+		if (reply != expected)
+		{
+			out << "position " << sout.str() << " shows " << reply;
+			++failures;
+		}
+	}
+	handle("delete check", pool, reply);
+	out << (failures ? "Check failed" : "Check passed") << std::endl;
+	return failures;
+}
+
+int main(int argc, char *argv[])
+{
+	std::ostream &out = std::cout;
+
+	std::string config;
+	for (int i = 1; i < argc; ++i)
+	{
+		config += argv[i];
+		config += " ";
+	}
+
+	std::string path = "alphaya.sock";
+	bool check_only = false;
+	IndexType thread_count = std::thread::hardware_concurrency();
+	IndexType memory = 1024;
+	std::string argument;
+	for (std::istringstream cfin(config);;)
+	{
+		cfin >> argument;
+		if (cfin.fail())
+		{
+			break;
+		}
+		if (argument == "socket")
+		{
+			cfin >> path;
+			continue;
+		}
+		if (argument == "threads")
+		{
+			cfin >> thread_count;
+			continue;
+		}
+		if (argument == "memory")
+		{
+			cfin >> memory;
+			continue;
+		}
+		if (argument == "check")
+		{
+			check_only = true;
+			continue;
+		}
+		out << "Unknown argument: " << argument << std::endl;
+		return 1;
+	}
+	session_memory = memory << 20;
+
+	if (check_only)
+	{
+		AlphaYa::ThreadPool pool(1);
+		return check(pool, out) ? 1 : 0;
+	}
+
+	const int listen_fd = AlphaYaExport::listen_unix(path);
+	if (listen_fd < 0)
+	{
+		out << "Cannot listen on " << path << std::endl;
+		return 1;
+	}
+	AlphaYa::ThreadPool pool(thread_count);
+	out << "Listening on " << path << " with " << pool.threads.size() << " search threads" << std::endl;
+	for (;;)
+	{
+		const int fd = ::accept(listen_fd, nullptr, nullptr);
+		if (fd < 0)
+		{
+			continue;
+		}
+		std::thread(serve, fd, std::ref(pool)).detach();
+	}
+	return 0;
+}
\ No newline at end of file
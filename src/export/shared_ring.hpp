@@ -0,0 +1,89 @@
+#pragma once
+
+/*
+Lock-free ring buffers in memory shared between processes
+Only POSIX systems are supported.
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include <sys/mman.h>
+
+namespace AlphaYaExport
+{
+	/*
+	Single producer, single consumer ring buffer of capacity items
+	An item is published by advancing tail after it is written, so a producer that dies while writing
+	publishes nothing, and a new producer can continue with the same ring.
+	Item should be trivially copyable, and capacity should be a power of 2.
+	*/
+	template <typename Item, std::size_t capacity>
+	class SharedRing
+	{
+	public:
+		static_assert(capacity && !(capacity & (capacity - 1)), "capacity should be a power of 2");
+
+		alignas(64) std::atomic<std::uint64_t> head;
+		alignas(64) std::atomic<std::uint64_t> tail;
+		alignas(64) Item items[capacity];
+
+		SharedRing() : head(0), tail(0) {}
+
+		/*
+		Append item, returns false if the ring is full
+		*/
+		bool push(const Item &item)
+		{
+			const std::uint64_t t = tail.load(std::memory_order_relaxed);
+			if (t - head.load(std::memory_order_acquire) == capacity)
+			{
+				return false;
+			}
+			items[t & (capacity - 1)] = item;
+			tail.store(t + 1, std::memory_order_release);
+			return true;
+		}
+
+		/*
+		Remove the oldest item into item, returns false if the ring is empty
+		*/
+		bool pop(Item &item)
+		{
+			const std::uint64_t h = head.load(std::memory_order_relaxed);
+			if (h == tail.load(std::memory_order_acquire))
+			{
+				return false;
+			}
+			item = items[h & (capacity - 1)];
+			head.store(h + 1, std::memory_order_release);
+			return true;
+		}
+
+		/*
+		Create count rings in anonymous shared memory, which is inherited by child processes after fork
+		Returns nullptr on failure.
+		*/
+		static SharedRing *create(std::size_t count)
+		{
+			void *address = ::mmap(nullptr, sizeof(SharedRing) * count, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+			if (address == MAP_FAILED)
+			{
+				return nullptr;
+			}
+			SharedRing *rings = (SharedRing *)address;
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				new (rings + i) SharedRing();
+			}
+			return rings;
+		}
+
+		static void destroy(SharedRing *rings, std::size_t count)
+		{
+			::munmap((void *)rings, sizeof(SharedRing) * count);
+		}
+	};
+};
\ No newline at end of file
@@ -0,0 +1,263 @@
+#pragma once
+
+/*
+Minimal stream socket helpers for the engine front ends, over Unix domain sockets or TCP
+Only POSIX systems are supported.
+*/
+
+#include <cstring>
+#include <string>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace AlphaYaExport
+{
+	/*
+	Create a Unix domain socket listening at path, returns -1 on failure
+	An existing file at path is removed first.
+	*/
+	int listen_unix(const std::string &path, int backlog = 16)
+	{
+		sockaddr_un address;
+		if (path.size() >= sizeof(address.sun_path))
+		{
+			return -1;
+		}
+		std::memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		std::strcpy(address.sun_path, path.c_str());
+		const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		if (fd < 0)
+		{
+			return -1;
+		}
+		::unlink(path.c_str());
+		if (::bind(fd, (const sockaddr *)&address, sizeof(address)) < 0 || ::listen(fd, backlog) < 0)
+		{
+			::close(fd);
+			return -1;
+		}
+		return fd;
+	}
+
+	/*
+	Connect to a Unix domain socket at path, returns -1 on failure
+	*/
+	int connect_unix(const std::string &path)
+	{
+		sockaddr_un address;
+		if (path.size() >= sizeof(address.sun_path))
+		{
+			return -1;
+		}
+		std::memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		std::strcpy(address.sun_path, path.c_str());
+		const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		if (fd < 0)
+		{
+			return -1;
+		}
+		if (::connect(fd, (const sockaddr *)&address, sizeof(address)) < 0)
+		{
+			::close(fd);
+			return -1;
+		}
+		return fd;
+	}
+
+	/*
+	Create a TCP socket listening at host:port, returns -1 on failure
+	An empty host listens on all interfaces.
+	*/
+	int listen_tcp(const std::string &host, const std::string &port, int backlog = 16)
+	{
+		addrinfo hints, *addresses;
+		std::memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_flags = AI_PASSIVE;
+		if (::getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &addresses))
+		{
+			return -1;
+		}
+		int fd = -1;
+		for (addrinfo *address = addresses; address && fd < 0; address = address->ai_next)
+		{
+			fd = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+			if (fd < 0)
+			{
+				continue;
+			}
+			const int on = 1;
+			::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+			if (::bind(fd, address->ai_addr, address->ai_addrlen) < 0 || ::listen(fd, backlog) < 0)
+			{
+				::close(fd);
+				fd = -1;
+			}
+		}
+		::freeaddrinfo(addresses);
+		return fd;
+	}
+
+	/*
+	Connect to a TCP socket at host:port, returns -1 on failure
+	Nagle's algorithm is disabled, since messages are small and latency matters.
+	*/
+	int connect_tcp(const std::string &host, const std::string &port)
+	{
+		addrinfo hints, *addresses;
+		std::memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		if (::getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses))
+		{
+			return -1;
+		}
+		int fd = -1;
+		for (addrinfo *address = addresses; address && fd < 0; address = address->ai_next)
+		{
+			fd = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+			if (fd < 0)
+			{
+				continue;
+			}
+			if (::connect(fd, address->ai_addr, address->ai_addrlen) < 0)
+			{
+				::close(fd);
+				fd = -1;
+			}
+		}
+		::freeaddrinfo(addresses);
+		if (fd >= 0)
+		{
+			const int on = 1;
+			::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+		}
+		return fd;
+	}
+
+	/*
+	Listen at or connect to address, which is tcp:HOST:PORT, unix:PATH or a path of a Unix domain socket
+	*/
+	int listen_address(const std::string &address)
+	{
+		if (address.compare(0, 4, "tcp:") == 0)
+		{
+			const std::string::size_type colon = address.rfind(':');
+			return listen_tcp(address.substr(4, colon - 4), address.substr(colon + 1));
+		}
+		return listen_unix(address.compare(0, 5, "unix:") == 0 ? address.substr(5) : address);
+	}
+
+	int connect_address(const std::string &address)
+	{
+		if (address.compare(0, 4, "tcp:") == 0)
+		{
+			const std::string::size_type colon = address.rfind(':');
+			return connect_tcp(address.substr(4, colon - 4), address.substr(colon + 1));
+		}
+		return connect_unix(address.compare(0, 5, "unix:") == 0 ? address.substr(5) : address);
+	}
+
+	/*
+	Line based connection over a stream socket
+	Lines are separated by '\n', and a trailing '\r' is removed.
+	*/
+	class Connection
+	{
+	public:
+		int fd;
+		std::string buffer;
+
+		Connection(int f) : fd(f) {}
+
+		~Connection()
+		{
+			if (fd >= 0)
+			{
+				::close(fd);
+			}
+		}
+
+		Connection(const Connection &) = delete;
+		Connection &operator=(const Connection &) = delete;
+
+		/*
+		Read a line into line, returns false if the connection is closed
+		*/
+		bool read_line(std::string &line)
+		{
+			for (;;)
+			{
+				const std::string::size_type end = buffer.find('\n');
+				if (end != std::string::npos)
+				{
+					line = buffer.substr(0, end);
+					buffer.erase(0, end + 1);
+					if (!line.empty() && line.back() == '\r')
+					{
+						line.pop_back();
+					}
+					return true;
+				}
+				char chunk[4096];
+				const ssize_t size = ::recv(fd, chunk, sizeof(chunk), 0);
+				if (size <= 0)
+				{
+					return false;
+				}
+				buffer.append(chunk, size);
+			}
+		}
+
+		/*
+		Read exactly size bytes into data, returns false if the connection is closed
+		Lines and raw bytes can be mixed, since both are read through buffer.
+		*/
+		bool read_bytes(std::string &data, std::string::size_type size)
+		{
+			while (buffer.size() < size)
+			{
+				char chunk[4096];
+				const ssize_t received = ::recv(fd, chunk, sizeof(chunk), 0);
+				if (received <= 0)
+				{
+					return false;
+				}
+				buffer.append(chunk, received);
+			}
+			data = buffer.substr(0, size);
+			buffer.erase(0, size);
+			return true;
+		}
+
+		/*
+		Write data completely, returns false if the connection is closed
+		*/
+		bool write(const std::string &data)
+		{
+			for (std::string::size_type sent = 0; sent < data.size();)
+			{
+				const ssize_t size = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+				if (size <= 0)
+				{
+					return false;
+				}
+				sent += size;
+			}
+			return true;
+		}
+
+		bool write_line(const std::string &line)
+		{
+			return write(line + "\n");
+		}
+	};
+};
\ No newline at end of file
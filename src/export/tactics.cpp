@@ -0,0 +1,319 @@
+#ifdef GAME_TIC_TAC_TOE
+#include "../mygames/tictactoe/export.hpp"
+#endif
+#ifdef GAME_GOMOKU
+#include "../mygames/gomoku/export.hpp"
+#endif
+
+#include "../game/thread_pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+Tactical suite runner: measure how fast "ai" agent configurations find the expected moves of a suite of positions
+Usage: tactics suite PATH [threads N] [scount N] [time MS] [configs PATH] [detail 1] [config CONFIG]
+config must be the last argument, since the agent config may contain spaces.
+Every line of configs is a configuration, and config adds one more (only the default configuration if neither is given).
+Suites of the games are in the folder tactics. Every line of a suite has tab-separated fields:
+name, expected actions separated by spaces, and the state in the format of init. Lines starting with # are skipped.
+Every configuration searches every position with scount simulations or for time milliseconds, as in analyze,
+and the jobs run in parallel on threads threads.
+A position is solved if the action played is expected, and the search locks onto it at the simulation
+after which the best action stays expected. The score of a configuration is the mean over positions
+of 1 - 0.5 * lock simulations / simulations for solved positions, and 0 for the others, in percent,
+so that solving more positions always counts more than solving them faster.
+Times are wall clock times, so they are only comparable between runs with the same threads.
+*/
+
+using AlphaYaExport::Action;
+using AlphaYaExport::Agent;
+using AlphaYaExport::IndexType;
+using AlphaYaExport::MCTSAgent;
+using AlphaYaExport::ScoreType;
+using AlphaYaExport::State;
+using AlphaYaExport::StopToken;
+
+using AlphaYaExport::mcts_agent;
+using AlphaYaExport::players;
+
+class Position
+{
+public:
+	std::string name;
+	std::vector<std::string> expected;
+	std::string state;
+};
+
+/*
+Result of searching a position, lock_simulations is 0 if the position is not solved
+*/
+class Result
+{
+public:
+	std::string action;
+	bool solved;
+	IndexType simulations, lock_simulations;
+	double seconds, lock_seconds;
+};
+
+std::string action_string(const Action &action)
+{
+	std::ostringstream sout;
+	action.output(sout);
+	return sout.str();
+}
+
+void run(const Position &position, const std::string &config, IndexType simulate_count, IndexType move_time, std::shared_ptr<std::promise<Result>> promise)
+{
+	Result result{"-", false, 0, 0, 0, 0};
+	State state;
+	state.init(position.state);
+	ScoreType scores[players];
+	std::unique_ptr<Agent> agent = mcts_agent(config);
+	MCTSAgent *mcts = dynamic_cast<MCTSAgent *>(agent.get());
+	if (state.calculateScore(scores) || !mcts)
+	{
+		promise->set_value(result);
+		return;
+	}
+	mcts->set_budget(simulate_count, move_time);
+	mcts->ponder = false;
+	// Expected actions by index, so that the timed search compares no strings
+	std::vector<bool> expected(State::action_count, false);
+	for (IndexType index = 0; index < State::action_count; ++index)
+	{
+		expected[index] = std::find(position.expected.begin(), position.expected.end(), action_string(Action::fromIndex(index))) != position.expected.end();
+	}
+
+	typedef std::chrono::steady_clock Clock;
+	const Clock::time_point start = Clock::now();
+	bool locked = false;
+	const MCTSAgent::Progress progress = [&](IndexType simulations, const Action &best, float value)
+	{
+		if (expected[best.index()] && !locked)
+		{
+			result.lock_simulations = simulations;
+			result.lock_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		}
+		locked = expected[best.index()];
+		result.simulations = simulations;
+	};
+	std::istringstream in;
+	std::ostringstream log;
+	const Action action = mcts->search(state, in, log, StopToken(), progress).action;
+	result.action = action_string(action);
+	result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	result.solved = expected[action.index()];
+	if (!result.solved)
+	{
+		result.lock_simulations = 0;
+		result.lock_seconds = 0;
+	}
+	promise->set_value(result);
+}
+
+int main(int argc, char *argv[])
+{
+	std::ostream &out = std::cout;
+
+	std::string arguments;
+	for (int i = 1; i < argc; ++i)
+	{
+		arguments += argv[i];
+		arguments += " ";
+	}
+
+	std::string suite_path;
+	std::string configs_path;
+	IndexType thread_count = std::thread::hardware_concurrency();
+	IndexType simulate_count = 0;
+	IndexType move_time = 0;
+	bool detail = false;
+	std::vector<std::string> configs;
+	std::string argument;
+	for (std::istringstream cfin(arguments);;)
+	{
+		cfin >> argument;
+		if (cfin.fail())
+		{
+			break;
+		}
+		if (argument == "suite")
+		{
+			cfin >> suite_path;
+			continue;
+		}
+		if (argument == "threads")
+		{
+			cfin >> thread_count;
+			continue;
+		}
+		if (argument == "scount")
+		{
+			cfin >> simulate_count;
+			continue;
+		}
+		if (argument == "time")
+		{
+			cfin >> move_time;
+			continue;
+		}
+		if (argument == "configs")
+		{
+			cfin >> configs_path;
+			continue;
+		}
+		if (argument == "detail")
+		{
+			cfin >> detail;
+			continue;
+		}
+		if (argument == "config")
+		{
+			std::string config;
+			cfin >> std::ws;
+			std::getline(cfin, config);
+			config.erase(config.find_last_not_of(' ') + 1);
+			configs.push_back(config);
+			break;
+		}
+		out << "Unknown argument: " << argument << std::endl;
+		return 1;
+	}
+	const auto lines = [](const std::string &path, std::vector<std::string> &result)
+	{
+		std::ifstream fin(path);
+		if (fin.fail())
+		{
+			return false;
+		}
+		for (std::string line; std::getline(fin, line);)
+		{
+			if (!line.empty() && line.back() == '\r')
+			{
+				line.pop_back();
+			}
+			if (!line.empty() && line[0] != '#')
+			{
+				result.push_back(line);
+			}
+		}
+		return true;
+	};
+	if (!configs_path.empty())
+	{
+		std::vector<std::string> more;
+		if (!lines(configs_path, more))
+		{
+			out << "Cannot open " << configs_path << std::endl;
+			return 1;
+		}
+		configs.insert(configs.begin(), more.begin(), more.end());
+	}
+	if (configs.empty())
+	{
+		configs.push_back("");
+	}
+	std::vector<std::string> suite;
+	if (suite_path.empty() || !lines(suite_path, suite))
+	{
+		out << "Cannot open suite " << suite_path << std::endl;
+		return 1;
+	}
+	std::vector<Position> positions;
+	for (const std::string &line : suite)
+	{
+		Position position;
+		std::istringstream sin(line);
+		std::string expected;
+		std::getline(sin, position.name, '\t');
+		std::getline(sin, expected, '\t');
+		std::getline(sin, position.state);
+		std::istringstream ein(expected);
+		for (std::string action; ein >> action;)
+		{
+			position.expected.push_back(action);
+		}
+		if (sin.fail() || position.expected.empty())
+		{
+			out << "Invalid suite line: " << line << std::endl;
+			return 1;
+		}
+		positions.push_back(position);
+	}
+
+	std::vector<std::future<Result>> futures;
+	{
+		AlphaYa::ThreadPool pool(thread_count);
+		out << "Running " << positions.size() << " positions with " << configs.size() << " configurations on " << pool.threads.size() << " threads" << std::endl;
+		for (const std::string &config : configs)
+		{
+			for (const Position &position : positions)
+			{
+				std::shared_ptr<std::promise<Result>> promise = std::make_shared<std::promise<Result>>();
+				futures.push_back(promise->get_future());
+				pool.submit(std::bind(run, position, config, simulate_count, move_time, promise));
+			}
+		}
+		for (std::future<Result> &future : futures)
+		{
+			future.wait();
+		}
+	}
+
+	out << std::fixed;
+	for (IndexType k = 0; k < configs.size(); ++k)
+	{
+		IndexType solved = 0;
+		double lock_simulations = 0, lock_seconds = 0, seconds = 0, score = 0;
+		if (detail)
+		{
+			out << std::endl
+				<< "Configuration " << k << ": " << configs[k] << std::endl
+				<< std::left << std::setw(24) << "position" << std::right << std::setw(8) << "action" << std::setw(8) << "solved"
+				<< std::setw(12) << "simulations" << std::setw(12) << "lock sims" << std::setw(12) << "lock ms" << std::endl;
+		}
+		for (IndexType i = 0; i < positions.size(); ++i)
+		{
+			const Result result = futures[k * positions.size() + i].get();
+			seconds += result.seconds;
+			if (result.solved)
+			{
+				++solved;
+				lock_simulations += result.lock_simulations;
+				lock_seconds += result.lock_seconds;
+				score += 1 - 0.5 * result.lock_simulations / std::max(result.simulations, (IndexType)1);
+			}
+			if (detail)
+			{
+				out << std::left << std::setw(24) << positions[i].name << std::right << std::setw(8) << result.action
+					<< std::setw(8) << (result.solved ? "yes" : "no") << std::setw(12) << result.simulations;
+				if (result.solved)
+				{
+					out << std::setw(12) << result.lock_simulations << std::setprecision(2) << std::setw(12) << result.lock_seconds * 1e3;
+				}
+				out << std::endl;
+			}
+		}
+		if (detail)
+		{
+			out << std::endl;
+		}
+		out << std::setprecision(1) << "Configuration " << k << ": solved " << solved << "/" << positions.size()
+			<< ", mean lock " << (solved ? lock_simulations / solved : 0.0) << " simulations, "
+			<< std::setprecision(2) << (solved ? lock_seconds * 1e3 / solved : 0.0) << " ms, total " << seconds << " s, "
+			<< std::setprecision(1) << "score " << 100 * score / positions.size() << " (" << configs[k] << ")" << std::endl;
+	}
+	return 0;
+}
\ No newline at end of file
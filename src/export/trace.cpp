@@ -0,0 +1,230 @@
+#ifdef GAME_TIC_TAC_TOE
+#include "../mygames/tictactoe/export.hpp"
+#endif
+#ifdef GAME_GOMOKU
+#include "../mygames/gomoku/export.hpp"
+#endif
+
+#include "../agent/checkpoint.hpp"
+#include "../agent/trace.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+Trace reader: summarize a search trace written by the "ai" agent with config trace PATH
+Usage: trace file PATH [search N] [top N] [points N]
+For every search (or only search N), the time of every phase of simulations is broken down,
+and the visit shares of the top root actions are printed at points evenly spaced simulation counts.
+*/
+
+using AlphaYaExport::Action;
+using AlphaYaExport::IndexType;
+using AlphaYaExport::State;
+
+using AlphaYa::TraceEvent;
+using AlphaYa::TraceHeader;
+
+/*
+Mean and percentiles of phase in microseconds
+*/
+void print_phase(std::ostream &out, const std::string &name, std::vector<std::uint64_t> cycles, std::uint64_t total, double cycles_per_second)
+{
+	std::sort(cycles.begin(), cycles.end());
+	std::uint64_t sum = 0;
+	for (const std::uint64_t value : cycles)
+	{
+		sum += value;
+	}
+	const double scale = 1e6 / cycles_per_second;
+	out << std::setw(8) << name
+		<< std::setw(12) << sum * scale / cycles.size()
+		<< std::setw(12) << cycles[cycles.size() / 2] * scale
+		<< std::setw(12) << cycles[cycles.size() * 99 / 100] * scale
+		<< std::setw(10) << (total ? 100.0 * sum / total : 0.0) << "%" << std::endl;
+}
+
+void summarize(std::ostream &out, const TraceHeader &header, const TraceEvent *events, IndexType top, IndexType points)
+{
+	const double cycles_per_second = header.cycles_per_second ? (double)header.cycles_per_second : 1e9;
+	const IndexType count = header.event_count;
+	IndexType pondered = 0, max_depth = 0;
+	std::uint64_t depth_sum = 0;
+	std::vector<std::uint64_t> select(count), expand(count), playout(count), backup(count), total(count);
+	std::uint64_t total_sum = 0;
+	std::vector<std::pair<IndexType, IndexType>> visits(State::action_count);
+	for (IndexType a = 0; a < State::action_count; ++a)
+	{
+		visits[a] = std::make_pair(0, a);
+	}
+	for (IndexType i = 0; i < count; ++i)
+	{
+		const TraceEvent &event = events[i];
+		pondered += event.pondered;
+		depth_sum += event.depth;
+		max_depth = std::max(max_depth, (IndexType)event.depth);
+		select[i] = event.select_cycles;
+		expand[i] = event.expand_cycles;
+		playout[i] = event.playout_cycles;
+		backup[i] = event.backup_cycles;
+		total[i] = select[i] + expand[i] + playout[i] + backup[i];
+		total_sum += total[i];
+		if (event.root_action < State::action_count)
+		{
+			++visits[event.root_action].first;
+		}
+	}
+	out << "Search " << header.search << ": " << count << " simulations (" << pondered << " pondered), "
+		<< header.dropped << " dropped, " << total_sum * 1e3 / cycles_per_second << " ms" << std::endl;
+	if (!count)
+	{
+		return;
+	}
+	out << std::fixed << std::setprecision(2);
+	out << std::setw(8) << "phase" << std::setw(12) << "mean us" << std::setw(12) << "p50 us" << std::setw(12) << "p99 us" << std::setw(11) << "share" << std::endl;
+	print_phase(out, "select", select, total_sum, cycles_per_second);
+	print_phase(out, "expand", expand, total_sum, cycles_per_second);
+	print_phase(out, "playout", playout, total_sum, cycles_per_second);
+	print_phase(out, "backup", backup, total_sum, cycles_per_second);
+	print_phase(out, "total", total, total_sum, cycles_per_second);
+	out << "Depth: mean " << (double)depth_sum / count << ", max " << max_depth << std::endl;
+
+	// Visit shares of the most visited root actions at the end of the search
+	std::sort(visits.begin(), visits.end(), std::greater<std::pair<IndexType, IndexType>>());
+	top = std::min(top, (IndexType)visits.size());
+	while (top && !visits[top - 1].first)
+	{
+		--top;
+	}
+	std::vector<IndexType> column(State::action_count, top);
+	out << "Visit share:" << std::endl
+		<< std::setw(12) << "simulations";
+	for (IndexType k = 0; k < top; ++k)
+	{
+		column[visits[k].second] = k;
+		std::ostringstream name;
+		Action::fromIndex(visits[k].second).output(name);
+		out << std::setw(8) << name.str();
+	}
+	out << std::endl;
+	std::vector<IndexType> counts(top + 1, 0);
+	for (IndexType i = 0, point = 1; i < count; ++i)
+	{
+		if (events[i].root_action < State::action_count)
+		{
+			++counts[column[events[i].root_action]];
+		}
+		if (i + 1 == count || (i + 1) * points >= point * count)
+		{
+			out << std::setw(12) << i + 1;
+			for (IndexType k = 0; k < top; ++k)
+			{
+				out << std::setw(7) << 100.0 * counts[k] / (i + 1) << "%";
+			}
+			out << std::endl;
+			while ((i + 1) * points >= point * count)
+			{
+				++point;
+			}
+		}
+	}
+	out.unsetf(std::ios::floatfield);
+	out << std::setprecision(6);
+}
+
+int main(int argc, char *argv[])
+{
+	std::ostream &out = std::cout;
+
+	std::string config;
+	for (int i = 1; i < argc; ++i)
+	{
+		config += argv[i];
+		config += " ";
+	}
+
+	std::string path;
+	bool all = true;
+	std::uint64_t search = 0;
+	IndexType top = 5;
+	IndexType points = 10;
+	std::string argument;
+	for (std::istringstream cfin(config);;)
+	{
+		cfin >> argument;
+		if (cfin.fail())
+		{
+			break;
+		}
+		if (argument == "file")
+		{
+			cfin >> path;
+			continue;
+		}
+		if (argument == "search")
+		{
+			cfin >> search;
+			all = false;
+			continue;
+		}
+		if (argument == "top")
+		{
+			cfin >> top;
+			continue;
+		}
+		if (argument == "points")
+		{
+			cfin >> points;
+			continue;
+		}
+		out << "Unknown argument: " << argument << std::endl;
+		return 1;
+	}
+	if (!points)
+	{
+		points = 1;
+	}
+
+	AlphaYa::MappedFile file;
+	if (path.empty() || !file.open(path))
+	{
+		out << "Cannot open trace file: " << path << std::endl;
+		return 1;
+	}
+	for (IndexType offset = 0; offset < file.size;)
+	{
+		TraceHeader header;
+		if (file.size - offset < sizeof(header))
+		{
+			out << "Truncated trace at byte " << offset << std::endl;
+			return 1;
+		}
+		std::memcpy(&header, file.data + offset, sizeof(header));
+		offset += sizeof(header);
+		if (header.magic != AlphaYa::trace_magic || (file.size - offset) / sizeof(TraceEvent) < header.event_count)
+		{
+			out << "Invalid trace at byte " << offset - sizeof(header) << std::endl;
+			return 1;
+		}
+		if (all || header.search == search)
+		{
+			std::vector<TraceEvent> events(header.event_count);
+			if (header.event_count)
+			{
+				std::memcpy(events.data(), file.data + offset, header.event_count * sizeof(TraceEvent));
+			}
+			summarize(out, header, events.data(), top, points);
+			out << std::endl;
+		}
+		offset += header.event_count * sizeof(TraceEvent);
+	}
+	return 0;
+}
\ No newline at end of file
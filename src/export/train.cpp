@@ -0,0 +1,436 @@
+#ifdef GAME_TIC_TAC_TOE
+#include "../mygames/tictactoe/export.hpp"
+#endif
+#ifdef GAME_GOMOKU
+#include "../mygames/gomoku/export.hpp"
+#endif
+
+#include "../nn/network.hpp"
+#include "../nn/trainer.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/*
+Trainer: train a policy/value network on the CPU from game records
+Usage: train input PATH [input PATH ...] [output PREFIX] [epochs N] [batch N] [threads N] [optimizer adam|sgd] [lr X] [decay X]
+             [hidden N] [vhidden N] [buffer N] [save N] [load PATH] [seed N]
+Every input is a record file of terminal or selfplay, which is streamed again in every epoch,
+and positions pass through a shuffle buffer of buffer positions on their way into batches.
+Every position is used under a random symmetry of the board.
+The policy learns the action played, and the value learns the final score of the player to move.
+Weights are written to PREFIX_STEP.bin every save steps and after every epoch (PREFIX is weights/<game> by default).
+Positions left over at the end of an epoch are trained as a smaller batch.
+load resumes from a weight file, whose layer sizes replace hidden and vhidden. Optimizer moments are not saved,
+so they restart at 0.
+*/
+
+using AlphaYaExport::Action;
+using AlphaYaExport::Data;
+using AlphaYaExport::Features;
+using AlphaYaExport::IndexType;
+using AlphaYaExport::ScoreType;
+using AlphaYaExport::State;
+
+using AlphaYaExport::players;
+using AlphaYaExport::record_prefix;
+
+using AlphaYa::NN::Network;
+using AlphaYa::NN::Sample;
+using AlphaYa::NN::Trainer;
+
+/*
+A position of a record, with the action played and the final score of the player to move
+*/
+class Position
+{
+public:
+	Data data;
+	IndexType action;
+	float value;
+};
+
+/*
+Reader of positions from record files, one game at a time
+Games of other games than record_prefix, and games with unknown or illegal actions, are skipped.
+*/
+class RecordReader
+{
+public:
+	std::vector<std::string> paths;
+	IndexType path_index;
+	std::ifstream fin;
+	std::unordered_map<std::string, IndexType> action_indices;
+	IndexType games, skipped;
+
+	RecordReader(const std::vector<std::string> &p) : paths(p), path_index(0), games(0), skipped(0)
+	{
+		for (IndexType index = 0; index < State::action_count; ++index)
+		{
+			std::ostringstream sout;
+			Action::fromIndex(index).output(sout);
+			action_indices.emplace(sout.str(), index);
+		}
+	}
+
+	bool line(std::string &text)
+	{
+		for (;;)
+		{
+			if (fin.is_open() && std::getline(fin, text))
+			{
+				if (!text.empty() && text.back() == '\r')
+				{
+					text.pop_back();
+				}
+				return true;
+			}
+			fin.close();
+			if (path_index == paths.size())
+			{
+				return false;
+			}
+			fin.clear();
+			fin.open(paths[path_index++]);
+		}
+	}
+
+	/*
+	Read the positions of the next game into positions, returns false at the end of all files
+	*/
+	bool next(std::vector<Position> &positions)
+	{
+		positions.clear();
+		std::string text;
+		for (; line(text) && text != "GAME";)
+		{
+		}
+		if (text != "GAME" || !line(text))
+		{
+			return false;
+		}
+		bool valid = text == record_prefix;
+		State state;
+		State::ActionSet actions;
+		std::vector<IndexType> movers;
+		for (; line(text) && text != "GAME";)
+		{
+			if (text == "INIT" && line(text))
+			{
+				state.init(text);
+				continue;
+			}
+			if (text == "STEP")
+			{
+				std::string player, action, after;
+				if (!line(player) || !line(action) || !line(after))
+				{
+					return false;
+				}
+				const auto found = action_indices.find(action);
+				ScoreType scores[players];
+				state.generateActionSet(actions);
+				if (found == action_indices.end() || state.calculateScore(scores) || !actions.test(found->second))
+				{
+					valid = false;
+				}
+				if (valid)
+				{
+					positions.push_back(Position{state.getData(), found->second, 0.0f});
+					movers.push_back(state.toMove());
+					state.move(Action::fromIndex(found->second));
+				}
+				continue;
+			}
+			if (text == "SCORE")
+			{
+				ScoreType scores[players];
+				for (IndexType player = 0; player < players; ++player)
+				{
+					if (!line(text))
+					{
+						return false;
+					}
+					scores[player] = std::stoll(text);
+				}
+				for (IndexType i = 0; i < positions.size(); ++i)
+				{
+					const ScoreType score = scores[movers[i]];
+					positions[i].value = score > 0 ? 1.0f : score < 0 ? -1.0f : 0.0f;
+				}
+				break;
+			}
+		}
+		++games;
+		if (!valid)
+		{
+			++skipped;
+			positions.clear();
+		}
+		return true;
+	}
+};
+
+/*
+Encode position under symmetry into sample
+*/
+void encode(const Position &position, IndexType symmetry, Sample &sample)
+{
+	std::uint16_t features[Features::cells];
+	const IndexType count = Features::encode(position.data, symmetry, features);
+	sample.features.assign(features, features + count);
+	bool occupied[Features::cells] = {};
+	for (IndexType f = 0; f < count; ++f)
+	{
+		occupied[features[f] % Features::cells] = true;
+	}
+	sample.legal.clear();
+	for (IndexType c = 0; c < Features::cells; ++c)
+	{
+		if (!occupied[c])
+		{
+			sample.legal.push_back((std::uint16_t)c);
+		}
+	}
+	sample.policy = Features::cell(Action::fromIndex(position.action), symmetry);
+	sample.value = position.value;
+}
+
+int main(int argc, char *argv[])
+{
+	std::ostream &out = std::cout;
+
+	std::string arguments;
+	for (int i = 1; i < argc; ++i)
+	{
+		arguments += argv[i];
+		arguments += " ";
+	}
+
+	std::vector<std::string> input_paths;
+	std::string output_prefix = "weights/" + record_prefix;
+	std::string load_path;
+	IndexType epochs = 10;
+	IndexType batch_size = 256;
+	IndexType thread_count = std::thread::hardware_concurrency();
+	std::string optimizer = "adam";
+	float learning_rate = 1e-3f;
+	float decay = 1e-5f;
+	IndexType hidden_count = 128;
+	IndexType value_hidden_count = 32;
+	IndexType buffer_size = 1 << 16;
+	IndexType save_interval = 1000;
+	std::uint64_t seed = 42;
+	std::string argument;
+	for (std::istringstream cfin(arguments);;)
+	{
+		cfin >> argument;
+		if (cfin.fail())
+		{
+			break;
+		}
+		if (argument == "input")
+		{
+			std::string path;
+			cfin >> path;
+			input_paths.push_back(path);
+			continue;
+		}
+		if (argument == "output")
+		{
+			cfin >> output_prefix;
+			continue;
+		}
+		if (argument == "load")
+		{
+			cfin >> load_path;
+			continue;
+		}
+		if (argument == "epochs")
+		{
+			cfin >> epochs;
+			continue;
+		}
+		if (argument == "batch")
+		{
+			cfin >> batch_size;
+			continue;
+		}
+		if (argument == "threads")
+		{
+			cfin >> thread_count;
+			continue;
+		}
+		if (argument == "optimizer")
+		{
+			cfin >> optimizer;
+			continue;
+		}
+		if (argument == "lr")
+		{
+			cfin >> learning_rate;
+			continue;
+		}
+		if (argument == "decay")
+		{
+			cfin >> decay;
+			continue;
+		}
+		if (argument == "hidden")
+		{
+			cfin >> hidden_count;
+			continue;
+		}
+		if (argument == "vhidden")
+		{
+			cfin >> value_hidden_count;
+			continue;
+		}
+		if (argument == "buffer")
+		{
+			cfin >> buffer_size;
+			continue;
+		}
+		if (argument == "save")
+		{
+			cfin >> save_interval;
+			continue;
+		}
+		if (argument == "seed")
+		{
+			cfin >> seed;
+			continue;
+		}
+		out << "Unknown argument: " << argument << std::endl;
+		return 1;
+	}
+	if (input_paths.empty() || !batch_size || !buffer_size || (optimizer != "adam" && optimizer != "sgd"))
+	{
+		out << "Usage: train input PATH [input PATH ...] [output PREFIX] [epochs N] [batch N] [threads N] [optimizer adam|sgd] [lr X] [decay X] "
+			<< "[hidden N] [vhidden N] [buffer N] [save N] [load PATH] [seed N]" << std::endl;
+		return 1;
+	}
+
+	Network network(Features::input_count, hidden_count, value_hidden_count, Features::output_count);
+	if (!load_path.empty())
+	{
+		if (!network.load(load_path) || network.input_count != Features::input_count || network.output_count != Features::output_count)
+		{
+			out << "Cannot load weights of this game from " << load_path << std::endl;
+			return 1;
+		}
+		out << "Loaded " << load_path << " at step " << network.step << std::endl;
+	}
+	else
+	{
+		network.randomize(seed);
+	}
+	Trainer trainer(network, thread_count, optimizer == "adam", learning_rate, decay);
+	out << "Network " << network.input_count << "-" << network.hidden_count << "-(" << network.output_count << ", "
+		<< network.value_hidden_count << "-1), " << network.parameters.size() << " parameters, "
+		<< trainer.thread_count << " threads" << std::endl;
+
+	const auto save = [&]()
+	{
+		std::ostringstream sout;
+		sout << output_prefix << "_" << std::setw(8) << std::setfill('0') << network.step << ".bin";
+		if (network.save(sout.str()))
+		{
+			out << "Saved " << sout.str() << std::endl;
+		}
+		else
+		{
+			out << "WARNING: cannot write " << sout.str() << std::endl;
+		}
+	};
+
+	typedef std::chrono::steady_clock Clock;
+	std::mt19937_64 engine(seed);
+	std::vector<Position> buffer, game;
+	buffer.reserve(buffer_size);
+	std::vector<Sample> batch(batch_size);
+	for (IndexType epoch = 1; epoch <= epochs; ++epoch)
+	{
+		const Clock::time_point start = Clock::now();
+		RecordReader reader(input_paths);
+		IndexType samples = 0, steps = 0, filled = 0;
+		double policy_sum = 0, value_sum = 0;
+		const auto train = [&]()
+		{
+			double policy_loss, value_loss;
+			trainer.step(batch, policy_loss, value_loss);
+			policy_sum += policy_loss;
+			value_sum += value_loss;
+			samples += batch.size();
+			++steps;
+			filled = 0;
+			if (save_interval && network.step % save_interval == 0)
+			{
+				save();
+			}
+		};
+		// Take a random position out of the buffer into the batch
+		const auto take = [&]()
+		{
+			const IndexType k = std::uniform_int_distribution<IndexType>(0, buffer.size() - 1)(engine);
+			encode(buffer[k], std::uniform_int_distribution<IndexType>(0, Features::symmetry_count - 1)(engine), batch[filled++]);
+			buffer[k] = buffer.back();
+			buffer.pop_back();
+			if (filled == batch_size)
+			{
+				train();
+			}
+		};
+		for (; reader.next(game);)
+		{
+			for (const Position &position : game)
+			{
+				if (buffer.size() == buffer_size)
+				{
+					take();
+				}
+				buffer.push_back(position);
+			}
+		}
+		for (; !buffer.empty();)
+		{
+			take();
+		}
+		// The positions left at the end of the epoch are trained as a smaller batch
+		if (filled)
+		{
+			batch.resize(filled);
+			train();
+			batch.resize(batch_size);
+		}
+		const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		if (epoch == 1)
+		{
+			out << "Read " << reader.games << " games (" << reader.skipped << " skipped)" << std::endl;
+		}
+		if (!steps)
+		{
+			out << "No positions to train on" << std::endl;
+			return 1;
+		}
+		out << std::fixed << std::setprecision(4)
+			<< "Epoch " << epoch << ": step " << network.step << ", " << samples << " samples, policy loss " << policy_sum / steps
+			<< ", value loss " << value_sum / steps << ", " << std::setprecision(0) << samples / seconds << " samples/s" << std::endl;
+		out.unsetf(std::ios::floatfield);
+		out << std::setprecision(6);
+		if (!save_interval || network.step % save_interval)
+		{
+			save();
+		}
+	}
+	return 0;
+}
\ No newline at end of file
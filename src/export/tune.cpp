@@ -0,0 +1,405 @@
+#ifdef GAME_TIC_TAC_TOE
+#include "../mygames/tictactoe/export.hpp"
+#endif
+#ifdef GAME_GOMOKU
+#include "../mygames/gomoku/export.hpp"
+#endif
+
+#include "../game/thread_pool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+SPSA tuner of numeric "ai" agent config keys by games between perturbed configs
+Usage: tune param NAME VALUE MIN MAX [param ...] [intparam NAME VALUE MIN MAX] [iterations N] [pairs N] [threads N]
+            [a A] [c C] [stability N] [opening N] [time MS] [checkpoint PATH] [seed N] [config CONFIG]
+config must be the last argument, since the agent config may contain spaces.
+Every param is a key of the config of mcts_agent with its initial value and range, and intparam is rounded when used.
+Configs with keys which mcts_agent does not use, such as keys unsupported by compact 1, are rejected,
+and pairs must be positive.
+Tuned values are appended to config, so that they replace its own values of the same keys.
+Every iteration k perturbs all parameters at once by +/- c_k in random directions, and plays pairs game pairs
+between the two perturbed configs in parallel on threads threads, with colors swapped within a pair
+and the same opening of opening random moves. The score s in [-1, 1] of the + config moves every parameter
+by a_k * s / (2 c_k) towards the winning side. Parameters are normalized into [0, 1] over their ranges,
+a_k = a / (k + 1 + stability)^0.602 and c_k = c / (k + 1)^0.101, and stability defaults to iterations / 10.
+With time, every move is searched for time milliseconds (the movetime key), so that a large scount in config
+tunes the strength per CPU second instead of per simulation.
+With checkpoint, the iteration and values are saved to PATH after every iteration, and resumed from PATH if it exists.
+The tuned config is written after every iteration and at the end.
+See: https://www.jhuapl.edu/SPSA/
+*/
+
+using AlphaYaExport::Action;
+using AlphaYaExport::Agent;
+using AlphaYaExport::IndexType;
+using AlphaYaExport::ScoreType;
+using AlphaYaExport::State;
+
+using AlphaYaExport::configure_mcts_agent;
+using AlphaYaExport::default_state;
+using AlphaYaExport::mcts_agent;
+using AlphaYaExport::players;
+
+class Parameter
+{
+public:
+	std::string name;
+	double low, high;
+	bool integer;
+
+	/*
+	Current value normalized into [0, 1]
+	*/
+	double position;
+
+	double value(double x) const
+	{
+		const double v = low + std::min(std::max(x, 0.0), 1.0) * (high - low);
+		return integer ? std::round(v) : v;
+	}
+
+	void set(double v)
+	{
+		position = high > low ? std::min(std::max((v - low) / (high - low), 0.0), 1.0) : 0.0;
+	}
+};
+
+/*
+config with the parameters at positions appended
+*/
+std::string tuned_config(const std::string &config, const std::vector<Parameter> &parameters, const std::vector<double> &positions)
+{
+	std::ostringstream sout;
+	sout << config;
+	for (IndexType i = 0; i < parameters.size(); ++i)
+	{
+		sout << (config.empty() && !i ? "" : " ") << parameters[i].name << " ";
+		if (parameters[i].integer)
+		{
+			sout << (long long)parameters[i].value(positions[i]);
+		}
+		else
+		{
+			sout << std::setprecision(6) << parameters[i].value(positions[i]);
+		}
+	}
+	return sout.str();
+}
+
+/*
+Play a pair of games between configs first and second from the same random opening, with colors swapped
+The sum of the scores of first is set to result.
+*/
+void play_pair(const std::string &first, const std::string &second, IndexType opening, std::uint64_t seed, std::shared_ptr<std::promise<ScoreType>> result)
+{
+	std::ostream null_out(nullptr);
+	std::istringstream in;
+	std::mt19937_64 engine(seed);
+	State start;
+	start.init(default_state);
+	ScoreType scores[players];
+	for (IndexType i = 0; i < opening && !start.calculateScore(scores); ++i)
+	{
+		State::ActionSet actions;
+		start.generateActionSet(actions);
+		IndexType r = std::uniform_int_distribution<IndexType>(0, actions.count() - 1)(engine);
+		for (IndexType index = 0;; ++index)
+		{
+			if (actions.test(index) && !r--)
+			{
+				start.move(Action::fromIndex(index));
+				break;
+			}
+		}
+	}
+	ScoreType total = 0;
+	for (IndexType swap = 0; swap < 2; ++swap)
+	{
+		std::unique_ptr<Agent> agents[players];
+		for (IndexType player = 0; player < players; ++player)
+		{
+			std::ostringstream sout;
+			sout << ((player == swap) ? first : second) << " seed " << (seed * players + player) % 4294967291u;
+			agents[player] = mcts_agent(sout.str());
+		}
+		State state = start;
+		while (!state.calculateScore(scores))
+		{
+			state.move(agents[state.toMove()]->move(state, in, null_out));
+		}
+		total += scores[swap];
+	}
+	result->set_value(total);
+}
+
+bool save_checkpoint(const std::string &path, IndexType iteration, const std::vector<Parameter> &parameters)
+{
+	const std::string temp_path = path + ".tmp";
+	{
+		std::ofstream fout(temp_path);
+		fout << "iteration " << iteration << std::endl
+			 << std::setprecision(17);
+		for (const Parameter &parameter : parameters)
+		{
+			fout << parameter.name << " " << parameter.low + parameter.position * (parameter.high - parameter.low) << std::endl;
+		}
+		fout.close();
+		if (fout.fail())
+		{
+			std::remove(temp_path.c_str());
+			return false;
+		}
+	}
+	std::remove(path.c_str());
+	return !std::rename(temp_path.c_str(), path.c_str());
+}
+
+/*
+Returns the iteration saved at path, and sets the values of the parameters saved there, 0 if there is no checkpoint
+*/
+IndexType load_checkpoint(const std::string &path, std::vector<Parameter> &parameters)
+{
+	std::ifstream fin(path);
+	std::string word;
+	IndexType iteration = 0;
+	if (!(fin >> word >> iteration) || word != "iteration")
+	{
+		return 0;
+	}
+	double value;
+	while (fin >> word >> value)
+	{
+		for (Parameter &parameter : parameters)
+		{
+			if (parameter.name == word)
+			{
+				parameter.set(value);
+			}
+		}
+	}
+	return iteration;
+}
+
+int main(int argc, char *argv[])
+{
+	std::ostream &out = std::cout;
+
+	std::string arguments;
+	for (int i = 1; i < argc; ++i)
+	{
+		arguments += argv[i];
+		arguments += " ";
+	}
+
+	std::vector<Parameter> parameters;
+	IndexType iterations = 100;
+	IndexType pairs = 8;
+	IndexType thread_count = std::thread::hardware_concurrency();
+	double a = 0.05, c = 0.1;
+	IndexType stability = 0;
+	bool stability_given = false;
+	IndexType opening = 2;
+	IndexType move_time = 0;
+	std::string checkpoint;
+	std::uint64_t seed = 42;
+	std::string config;
+	std::string argument;
+	for (std::istringstream cfin(arguments);;)
+	{
+		cfin >> argument;
+		if (cfin.fail())
+		{
+			break;
+		}
+		if (argument == "param" || argument == "intparam")
+		{
+			Parameter parameter;
+			double value;
+			cfin >> parameter.name >> value >> parameter.low >> parameter.high;
+			if (cfin.fail() || parameter.high < parameter.low)
+			{
+				out << "Invalid " << argument << " " << parameter.name << std::endl;
+				return 1;
+			}
+			parameter.integer = argument == "intparam";
+			parameter.set(value);
+			parameters.push_back(parameter);
+			continue;
+		}
+		if (argument == "iterations")
+		{
+			cfin >> iterations;
+			continue;
+		}
+		if (argument == "pairs")
+		{
+			cfin >> pairs;
+			continue;
+		}
+		if (argument == "threads")
+		{
+			cfin >> thread_count;
+			continue;
+		}
+		if (argument == "a")
+		{
+			cfin >> a;
+			continue;
+		}
+		if (argument == "c")
+		{
+			cfin >> c;
+			continue;
+		}
+		if (argument == "stability")
+		{
+			cfin >> stability;
+			stability_given = true;
+			continue;
+		}
+		if (argument == "opening")
+		{
+			cfin >> opening;
+			continue;
+		}
+		if (argument == "time")
+		{
+			cfin >> move_time;
+			continue;
+		}
+		if (argument == "checkpoint")
+		{
+			cfin >> checkpoint;
+			continue;
+		}
+		if (argument == "seed")
+		{
+			cfin >> seed;
+			continue;
+		}
+		if (argument == "config")
+		{
+			cfin >> std::ws;
+			std::getline(cfin, config);
+			config.erase(config.find_last_not_of(' ') + 1);
+			break;
+		}
+		out << "Unknown argument: " << argument << std::endl;
+		return 1;
+	}
+	if (!pairs)
+	{
+		out << "pairs must be positive" << std::endl;
+		return 1;
+	}
+	if (parameters.empty())
+	{
+		out << "Usage: tune param NAME VALUE MIN MAX [param ...] [intparam NAME VALUE MIN MAX] [iterations N] [pairs N] [threads N]" << std::endl
+			<< "            [a A] [c C] [stability N] [opening N] [time MS] [checkpoint PATH] [seed N] [config CONFIG]" << std::endl;
+		return 1;
+	}
+	if (!stability_given)
+	{
+		stability = iterations / 10;
+	}
+	if (move_time)
+	{
+		std::ostringstream sout;
+		sout << config << (config.empty() ? "" : " ") << "movetime " << move_time;
+		config = sout.str();
+	}
+	IndexType first = 0;
+	if (!checkpoint.empty())
+	{
+		first = load_checkpoint(checkpoint, parameters);
+		if (first)
+		{
+			out << "Resumed from " << checkpoint << " at iteration " << first << std::endl;
+		}
+	}
+
+	std::vector<double> positions(parameters.size());
+	const auto current = [&]()
+	{
+		for (IndexType i = 0; i < parameters.size(); ++i)
+		{
+			positions[i] = parameters[i].position;
+		}
+		return tuned_config(config, parameters, positions);
+	};
+	std::vector<std::string> unknown;
+	configure_mcts_agent(current(), unknown);
+	if (!unknown.empty())
+	{
+		out << "Agent config words which are not used:";
+		for (const std::string &word : unknown)
+		{
+			out << " " << word;
+		}
+		out << std::endl;
+		return 1;
+	}
+	AlphaYa::ThreadPool pool(thread_count);
+	out << "Tuning " << parameters.size() << " parameters with " << pairs << " game pairs per iteration on " << pool.threads.size() << " threads" << std::endl
+		<< "Initial config: " << current() << std::endl;
+	std::mt19937_64 engine(seed);
+	for (IndexType k = 0; k < first; ++k)
+	{
+		engine.discard(parameters.size() + pairs);
+	}
+	out << std::fixed;
+	for (IndexType k = first; k < iterations; ++k)
+	{
+		const double step = a / std::pow(k + 1 + stability, 0.602);
+		const double perturbation = c / std::pow(k + 1, 0.101);
+		std::vector<double> directions(parameters.size()), plus(parameters.size()), minus(parameters.size());
+		for (IndexType i = 0; i < parameters.size(); ++i)
+		{
+			directions[i] = engine() & 1 ? 1.0 : -1.0;
+			plus[i] = parameters[i].position + perturbation * directions[i];
+			minus[i] = parameters[i].position - perturbation * directions[i];
+		}
+		const std::string plus_config = tuned_config(config, parameters, plus);
+		const std::string minus_config = tuned_config(config, parameters, minus);
+		std::vector<std::future<ScoreType>> results;
+		for (IndexType p = 0; p < pairs; ++p)
+		{
+			std::shared_ptr<std::promise<ScoreType>> result = std::make_shared<std::promise<ScoreType>>();
+			results.push_back(result->get_future());
+			pool.submit(std::bind(play_pair, plus_config, minus_config, opening, engine(), result));
+		}
+		ScoreType total = 0;
+		for (std::future<ScoreType> &result : results)
+		{
+			total += result.get();
+		}
+		const double score = (double)total / (2 * pairs);
+		for (IndexType i = 0; i < parameters.size(); ++i)
+		{
+			parameters[i].position = std::min(std::max(parameters[i].position + step * score / (2 * perturbation * directions[i]), 0.0), 1.0);
+		}
+		out << "Iteration " << k + 1 << "/" << iterations << ": score " << std::setprecision(3) << score
+			<< " of + over -, config: " << current() << std::endl;
+		if (!checkpoint.empty() && !save_checkpoint(checkpoint, k + 1, parameters))
+		{
+			out << "Failed to save " << checkpoint << std::endl;
+		}
+	}
+	out << "Tuned config: " << current() << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "game.hpp"
+
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace AlphaYa
+{
+	/*
+	Number of set bits of x
+	*/
+	inline IndexType popcount(std::uint64_t x)
+	{
+#ifdef _MSC_VER
+		return (IndexType)__popcnt64(x);
+#else
+		return (IndexType)__builtin_popcountll(x);
+#endif
+	}
+
+	/*
+	Index of the lowest set bit of x, x should not be 0
+	*/
+	inline IndexType lowest_bit(std::uint64_t x)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward64(&index, x);
+		return (IndexType)index;
+#else
+		return (IndexType)__builtin_ctzll(x);
+#endif
+	}
+
+	/*
+	Index of the k-th (from 0) set bit of x, x should have more than k set bits
+	*/
+	inline IndexType select_bit(std::uint64_t x, IndexType k)
+	{
+		IndexType offset = 0;
+		for (IndexType half = 32; half >= 8; half >>= 1)
+		{
+			const std::uint64_t low = x & ((((std::uint64_t)1) << half) - 1);
+			const IndexType count = popcount(low);
+			if (k >= count)
+			{
+				k -= count;
+				x >>= half;
+				offset += half;
+			}
+			else
+			{
+				x = low;
+			}
+		}
+		for (; k; --k)
+		{
+			x &= x - 1;
+		}
+		return offset + lowest_bit(x);
+	}
+
+	/*
+	Fixed size set of indices in [0, bits)
+	*/
+	template <IndexType bits>
+	class BitSet
+	{
+	public:
+		static constexpr IndexType word_count = (bits + 63) / 64;
+		std::uint64_t words[word_count];
+
+		void clear()
+		{
+			for (IndexType w = 0; w < word_count; ++w)
+			{
+				words[w] = 0;
+			}
+		}
+
+		bool empty() const
+		{
+			for (IndexType w = 0; w < word_count; ++w)
+			{
+				if (words[w])
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		IndexType count() const
+		{
+			IndexType total = 0;
+			for (IndexType w = 0; w < word_count; ++w)
+			{
+				total += popcount(words[w]);
+			}
+			return total;
+		}
+
+		bool test(IndexType index) const
+		{
+			return words[index >> 6] >> (index & 63) & 1;
+		}
+
+		void set(IndexType index)
+		{
+			words[index >> 6] |= ((std::uint64_t)1) << (index & 63);
+		}
+
+		void reset(IndexType index)
+		{
+			words[index >> 6] &= ~(((std::uint64_t)1) << (index & 63));
+		}
+
+		/*
+		Index of the k-th (from 0) element, the set should have more than k elements
+		*/
+		IndexType select(IndexType k) const
+		{
+			for (IndexType w = 0;; ++w)
+			{
+				const IndexType count = popcount(words[w]);
+				if (k < count)
+				{
+					return (w << 6) + select_bit(words[w], k);
+				}
+				k -= count;
+			}
+		}
+	};
+};
\ No newline at end of file
@@ -1,59 +1,77 @@
-#pragma once
-
-#include <cstdint>
-#include <ostream>
-#include <type_traits>
-#include <vector>
-
-namespace AlphaYa
-{
-	typedef std::size_t IndexType;
-	typedef std::int64_t ScoreType;
-
-	class Action
-	{
-	public:
-		virtual void output(std::ostream &out) const = 0;
-	};
-
-	template <IndexType n, typename DataType, typename ActionType, typename = typename std::enable_if<std::is_base_of<Action, ActionType>::value>::type>
-	class State
-	{
-	public:
-		typedef ActionType Action;
-		typedef DataType Data;
-		static constexpr IndexType players = n;
-		static constexpr IndexType byte_count = sizeof(DataType);
-
-		union
-		{
-			DataType content;
-			std::uint8_t bytes[byte_count];
-		} data;
-
-		DataType &getData()
-		{
-			return data.content;
-		}
-		const DataType &getData() const
-		{
-			return data.content;
-		}
-		std::uint8_t *getBytes()
-		{
-			return data.bytes;
-		}
-		const std::uint8_t *getBytes() const
-		{
-			return data.bytes;
-		}
-
-		virtual IndexType toMove() const = 0;
-		virtual std::vector<Action> generateActions() const = 0;
-		virtual void move(const Action &action) = 0;
-		virtual bool calculateScore(ScoreType scores[players]) const = 0;
-
-		virtual void init(const std::string &state_string) = 0;
-		virtual void output(std::ostream &out, const std::string &method) const = 0;
-	};
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+namespace AlphaYa
+{
+	typedef std::size_t IndexType;
+	typedef std::int64_t ScoreType;
+
+	/*
+	Base class of game actions
+	Actions are copied into every search tree edge, so they carry no virtual table.
+	A derived action must provide:
+	void output(std::ostream &out) const
+	bool operator==(const ActionType &o) const
+	*/
+	class Action
+	{
+	};
+
+	/*
+	Base class of game states
+	A derived state must also make moves in place, returning the information needed to take them back:
+	typedef Undo: undo information of a move
+	Undo move(const Action &action): make action for the player to move
+	void undo(const Action &action, const Undo &undo): take back action, which should be the last move
+	std::uint64_t hash() const: hash of the state, equal for equal states, and maintained by move and undo
+	Searches can then run on one mutable state instead of copying the state at every step.
+	Games used with MCTSAgent must also index their actions densely:
+	static constexpr IndexType action_count: actions have indices in [0, action_count)
+	typedef BitSet<action_count> ActionSet (see bits.hpp)
+	void generateActionSet(ActionSet &actions) const: same actions as generateActions, as a set of indices
+	IndexType Action::index() const, and static Action Action::fromIndex(IndexType index)
+	*/
+	template <IndexType n, typename DataType, typename ActionType, typename = typename std::enable_if<std::is_base_of<Action, ActionType>::value>::type>
+	class State
+	{
+	public:
+		typedef ActionType Action;
+		typedef DataType Data;
+		static constexpr IndexType players = n;
+		static constexpr IndexType byte_count = sizeof(DataType);
+
+		union
+		{
+			DataType content;
+			std::uint8_t bytes[byte_count];
+		} data;
+
+		DataType &getData()
+		{
+			return data.content;
+		}
+		const DataType &getData() const
+		{
+			return data.content;
+		}
+		std::uint8_t *getBytes()
+		{
+			return data.bytes;
+		}
+		const std::uint8_t *getBytes() const
+		{
+			return data.bytes;
+		}
+
+		virtual IndexType toMove() const = 0;
+		virtual std::vector<Action> generateActions() const = 0;
+		virtual bool calculateScore(ScoreType scores[players]) const = 0;
+
+		virtual void init(const std::string &state_string) = 0;
+		virtual void output(std::ostream &out, const std::string &method) const = 0;
+	};
 };
\ No newline at end of file
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "game.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace AlphaYa
+{
+	/*
+	Perft: count leaf positions of the game tree to a fixed depth
+	Terminal positions have no children, so they are only counted at the last depth.
+	See: https://www.chessprogramming.org/Perft
+	*/
+	template <typename StateType>
+	class Perft
+	{
+	public:
+		static constexpr IndexType players = StateType::players;
+
+		typedef StateType State;
+		typedef typename State::Action Action;
+		typedef typename State::Data Data;
+		typedef std::uint64_t CountType;
+
+		/*
+		Transposition table entry
+		key is stored xor-ed with count, so that torn writes from other threads are detected
+		See: https://www.chessprogramming.org/Shared_Hash_Table#Lockless
+		*/
+		class Entry
+		{
+		public:
+			std::atomic<std::uint64_t> key, count;
+		};
+
+		std::unique_ptr<Entry[]> table;
+		std::uint64_t table_mask;
+
+		/*
+		hash_bytes is the size of transposition table in bytes, 0 to disable it
+		*/
+		Perft(std::uint64_t hash_bytes = 0) : table_mask(0)
+		{
+			std::uint64_t size = 1;
+			while ((size << 1) * sizeof(Entry) <= hash_bytes)
+			{
+				size <<= 1;
+			}
+			if (size * sizeof(Entry) <= hash_bytes)
+			{
+				table.reset(new Entry[size]);
+				for (std::uint64_t i = 0; i < size; ++i)
+				{
+					table[i].key.store(0, std::memory_order_relaxed);
+					table[i].count.store(0, std::memory_order_relaxed);
+				}
+				table_mask = size - 1;
+			}
+		}
+
+		/*
+		Hash of state mixed with depth
+		*/
+		static std::uint64_t hash(const State &state, IndexType depth)
+		{
+			const std::uint64_t h = state.hash() ^ (depth * 0x9E3779B97F4A7C15ull);
+			return h ? h : 1;
+		}
+
+		/*
+		Count leaves below state, whose moves are made and taken back in place
+		*/
+		CountType count(State &state, IndexType depth)
+		{
+			if (!depth)
+			{
+				return 1;
+			}
+			ScoreType scores[players];
+			if (state.calculateScore(scores))
+			{
+				return 0;
+			}
+			const std::vector<Action> actions = state.generateActions();
+			if (depth == 1)
+			{
+				return actions.size();
+			}
+			std::uint64_t key = 0;
+			if (table)
+			{
+				key = hash(state, depth);
+				const Entry &entry = table[key & table_mask];
+				const std::uint64_t count = entry.count.load(std::memory_order_relaxed);
+				if ((entry.key.load(std::memory_order_relaxed) ^ count) == key)
+				{
+					return count;
+				}
+			}
+			CountType total = 0;
+			for (const Action &action : actions)
+			{
+				const typename State::Undo undo = state.move(action);
+				total += count(state, depth - 1);
+				state.undo(action, undo);
+			}
+			if (table)
+			{
+				Entry &entry = table[key & table_mask];
+				entry.key.store(key ^ total, std::memory_order_relaxed);
+				entry.count.store(total, std::memory_order_relaxed);
+			}
+			return total;
+		}
+
+		/*
+		Count leaves under each root action using thread_count threads
+		Root actions are handed out one by one, and the counts are written into divide in the order of generateActions.
+		*/
+		CountType count(const State &state, IndexType depth, IndexType thread_count, std::vector<std::pair<Action, CountType>> &divide)
+		{
+			divide.clear();
+			ScoreType scores[players];
+			if (!depth || state.calculateScore(scores))
+			{
+				State current = state;
+				return count(current, depth);
+			}
+			for (const Action &action : state.generateActions())
+			{
+				divide.emplace_back(action, 0);
+			}
+			std::atomic<IndexType> next(0);
+			const auto work = [&]()
+			{
+				State current = state;
+				for (IndexType i; (i = next.fetch_add(1)) < divide.size();)
+				{
+					const typename State::Undo undo = current.move(divide[i].first);
+					divide[i].second = count(current, depth - 1);
+					current.undo(divide[i].first, undo);
+				}
+			};
+			std::vector<std::thread> threads;
+			for (IndexType i = 1; i < thread_count; ++i)
+			{
+				threads.emplace_back(work);
+			}
+			work();
+			for (std::thread &thread : threads)
+			{
+				thread.join();
+			}
+			CountType total = 0;
+			for (const std::pair<Action, CountType> &item : divide)
+			{
+				total += item.second;
+			}
+			return total;
+		}
+	};
+};
\ No newline at end of file
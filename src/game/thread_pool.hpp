@@ -0,0 +1,82 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace AlphaYa
+{
+	/*
+	Fixed size thread pool running jobs in FIFO order
+	The destructor waits until all queued jobs are finished.
+	*/
+	class ThreadPool
+	{
+	public:
+		std::mutex mutex;
+		std::condition_variable condition;
+		std::deque<std::function<void()>> jobs;
+		std::vector<std::thread> threads;
+		bool stop;
+
+		ThreadPool(std::size_t thread_count) : stop(false)
+		{
+			if (!thread_count)
+			{
+				thread_count = 1;
+			}
+			for (std::size_t i = 0; i < thread_count; ++i)
+			{
+				threads.emplace_back(&ThreadPool::work, this);
+			}
+		}
+
+		~ThreadPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stop = true;
+			}
+			condition.notify_all();
+			for (std::thread &thread : threads)
+			{
+				thread.join();
+			}
+		}
+
+		void submit(const std::function<void()> &job)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				jobs.push_back(job);
+			}
+			condition.notify_one();
+		}
+
+		void work()
+		{
+			for (;;)
+			{
+				std::function<void()> job;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					while (!stop && jobs.empty())
+					{
+						condition.wait(lock);
+					}
+					if (jobs.empty())
+					{
+						return;
+					}
+					job = std::move(jobs.front());
+					jobs.pop_front();
+				}
+				job();
+			}
+		}
+	};
+};
\ No newline at end of file
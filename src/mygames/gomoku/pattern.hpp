@@ -0,0 +1,318 @@
+#pragma once
+
+#include "../../game/game.hpp"
+#include "../../agent/heuristic.hpp"
+#include "game.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace AlphaYa
+{
+	namespace Gomoku
+	{
+		/*
+		Shape of the line through an empty cell, if a player puts a stone there
+		FIVE: five in a row
+		OPEN_FOUR: two cells make FIVE, FOUR: one cell makes FIVE
+		OPEN_THREE (THREE, OPEN_TWO, TWO, ONE): one more stone can make OPEN_FOUR (FOUR, OPEN_THREE, THREE, TWO)
+		*/
+		enum Shape : std::uint8_t
+		{
+			NONE,
+			ONE,
+			TWO,
+			OPEN_TWO,
+			THREE,
+			OPEN_THREE,
+			FOUR,
+			OPEN_FOUR,
+			FIVE,
+			SHAPE_COUNT
+		};
+
+		/*
+		Shapes of all line windows
+		A window is the 8 cells within distance radius of a center cell along a line, from one end to the other.
+		Cell k of the window takes bits [2k, 2k + 2) of the key:
+		0 for empty, 1 for a stone of the player, 2 for a stone of the opponent or outside the board.
+		The center cell is taken as a stone of the player.
+		*/
+		class ShapeTable
+		{
+		public:
+			static_assert(GOMOKU_WIN_LENGTH == 5, "shapes are defined for five in a row");
+			static constexpr IndexType radius = 4;
+			static constexpr IndexType window_bits = 4 * radius;
+
+			std::uint8_t shapes[1 << window_bits];
+
+			ShapeTable()
+			{
+				std::memset(shapes, SHAPE_COUNT, sizeof(shapes));
+				for (IndexType key = 0; key < (((IndexType)1) << window_bits); ++key)
+				{
+					classify(key);
+				}
+			}
+
+			static const ShapeTable &get()
+			{
+				static const ShapeTable table;
+				return table;
+			}
+
+			/*
+			Bit p of the result is set if position p of the line (center at radius) has a stone of the player
+			Returns 0 if the key is invalid.
+			*/
+			static IndexType stones(IndexType key)
+			{
+				IndexType mask = ((IndexType)1) << radius;
+				for (IndexType k = 0; k < 2 * radius; ++k)
+				{
+					const IndexType cell = key >> (2 * k) & 3;
+					if (cell == 3)
+					{
+						return 0;
+					}
+					if (cell == 1)
+					{
+						mask |= ((IndexType)1) << (k < radius ? k : k + 1);
+					}
+				}
+				return mask;
+			}
+
+			static bool five(IndexType mask)
+			{
+				for (IndexType start = 0; start <= radius; ++start)
+				{
+					if ((mask >> start & 0x1F) == 0x1F)
+					{
+						return true;
+					}
+				}
+				return false;
+			}
+
+			Shape classify(IndexType key)
+			{
+				if (shapes[key] != SHAPE_COUNT)
+				{
+					return (Shape)shapes[key];
+				}
+				Shape shape = NONE;
+				const IndexType mask = stones(key);
+				if (mask && five(mask))
+				{
+					shape = FIVE;
+				}
+				else if (mask)
+				{
+					IndexType wins = 0;
+					for (IndexType k = 0; k < 2 * radius; ++k)
+					{
+						if (!(key >> (2 * k) & 3) && five(stones(key | ((IndexType)1) << (2 * k))))
+						{
+							++wins;
+						}
+					}
+					if (wins)
+					{
+						shape = wins >= 2 ? OPEN_FOUR : FOUR;
+					}
+					else
+					{
+						for (IndexType k = 0; k < 2 * radius; ++k)
+						{
+							if (key >> (2 * k) & 3)
+							{
+								continue;
+							}
+							const Shape next = classify(key | ((IndexType)1) << (2 * k));
+							const Shape promoted = next == OPEN_FOUR ? OPEN_THREE : next == FOUR ? THREE : next == OPEN_THREE ? OPEN_TWO : next == THREE ? TWO : next == OPEN_TWO || next == TWO ? ONE : NONE;
+							if (shape < promoted)
+							{
+								shape = promoted;
+							}
+						}
+					}
+				}
+				shapes[key] = shape;
+				return shape;
+			}
+		};
+
+		/*
+		Incremental line pattern evaluator
+		For every empty cell, player and direction, the window key of the line through the cell is kept,
+		so a move only sets one cell of the keys of the cells on the 4 lines through it.
+		The score of a cell for a player is the sum of shape_score over its 4 shapes.
+		*/
+		template <IndexType height, IndexType width>
+		class PatternEvaluator : public Heuristic<MNK::MNKState<height, width, GOMOKU_WIN_LENGTH>>
+		{
+		public:
+			typedef MNK::MNKState<height, width, GOMOKU_WIN_LENGTH> State;
+			typedef typename State::Action Action;
+			typedef typename State::Data Data;
+			typedef Heuristic<State> Base;
+
+			static constexpr IndexType radius = ShapeTable::radius;
+			static constexpr IndexType directions = 4;
+
+			/*
+			Directions are horizontal, vertical, diagonal and anti-diagonal
+			*/
+			static int row_step(IndexType d)
+			{
+				return d ? 1 : 0;
+			}
+			static int column_step(IndexType d)
+			{
+				return d == 1 ? 0 : d == 3 ? -1 : 1;
+			}
+
+			static std::int32_t shape_score(Shape shape)
+			{
+				static const std::int32_t scores[SHAPE_COUNT] = {0, 0, 8, 24, 30, 120, 150, 1200, 20000};
+				return scores[shape];
+			}
+
+			/*
+			board is 0 for empty, 1 for X and 2 for O
+			*/
+			std::uint8_t board[height][width];
+			std::uint16_t keys[2][height][width][directions];
+			std::int32_t scores[2][height][width];
+			std::int64_t totals[2];
+			IndexType side;
+
+			std::unique_ptr<Base> clone() const
+			{
+				return std::unique_ptr<Base>(new PatternEvaluator(*this));
+			}
+
+			void assign(const Base &other)
+			{
+				*this = static_cast<const PatternEvaluator &>(other);
+			}
+
+			static bool inside(int i, int j)
+			{
+				return i >= 0 && i < (int)height && j >= 0 && j < (int)width;
+			}
+
+			Shape shape(IndexType player, IndexType i, IndexType j, IndexType d) const
+			{
+				return (Shape)ShapeTable::get().shapes[keys[player][i][j][d]];
+			}
+
+			void update_score(IndexType player, IndexType i, IndexType j)
+			{
+				std::int32_t score = 0;
+				if (!board[i][j])
+				{
+					for (IndexType d = 0; d < directions; ++d)
+					{
+						score += shape_score(shape(player, i, j, d));
+					}
+				}
+				totals[player] += score - scores[player][i][j];
+				scores[player][i][j] = score;
+			}
+
+			void init(const State &state)
+			{
+				const Data &data = state.getData();
+				side = state.toMove();
+				for (IndexType i = 0; i < height; ++i)
+				{
+					for (IndexType j = 0; j < width; ++j)
+					{
+						board[i][j] = (data.bitboard0[i] >> j & 1) ? 1 : (data.bitboard1[i] >> j & 1) ? 2 : 0;
+					}
+				}
+				totals[0] = totals[1] = 0;
+				for (IndexType player = 0; player < 2; ++player)
+				{
+					for (IndexType i = 0; i < height; ++i)
+					{
+						for (IndexType j = 0; j < width; ++j)
+						{
+							for (IndexType d = 0; d < directions; ++d)
+							{
+								std::uint16_t key = 0;
+								for (int t = -(int)radius, k = 0; t <= (int)radius; ++t)
+								{
+									if (!t)
+									{
+										continue;
+									}
+									const int ti = (int)i + t * row_step(d), tj = (int)j + t * column_step(d);
+									const IndexType cell = !inside(ti, tj) ? 2 : !board[ti][tj] ? 0 : board[ti][tj] == player + 1 ? 1 : 2;
+									key |= (std::uint16_t)(cell << (2 * k++));
+								}
+								keys[player][i][j][d] = key;
+							}
+							scores[player][i][j] = 0;
+							update_score(player, i, j);
+						}
+					}
+				}
+			}
+
+			void move(const Action &action)
+			{
+				const int i = (int)action.row(), j = (int)action.column();
+				board[i][j] = (std::uint8_t)(side + 1);
+				for (IndexType player = 0; player < 2; ++player)
+				{
+					update_score(player, i, j);
+				}
+				for (IndexType d = 0; d < directions; ++d)
+				{
+					for (int t = -(int)radius; t <= (int)radius; ++t)
+					{
+						const int ti = i + t * row_step(d), tj = j + t * column_step(d);
+						if (!t || !inside(ti, tj))
+						{
+							continue;
+						}
+						// The move is at offset -t from (ti, tj)
+						const IndexType k = (IndexType)(t > 0 ? (int)radius - t : (int)radius - t - 1);
+						for (IndexType player = 0; player < 2; ++player)
+						{
+							keys[player][ti][tj][d] |= (std::uint16_t)((player == side ? 1 : 2) << (2 * k));
+							if (!board[ti][tj])
+							{
+								update_score(player, ti, tj);
+							}
+						}
+					}
+				}
+				side ^= 1;
+			}
+
+			/*
+			Attacking and defending cells are both urgent, so the score of the opponent counts 4/5
+			*/
+			float prior(const Action &action) const
+			{
+				const IndexType i = action.row(), j = action.column();
+				const float score = (float)(scores[side][i][j] + scores[side ^ 1][i][j] * 4 / 5);
+				return (score + 0.05f) / (score + 2000.05f);
+			}
+
+			float evaluate() const
+			{
+				return std::tanh((float)(totals[side] - totals[side ^ 1]) / 2000.0f);
+			}
+		};
+
+		typedef PatternEvaluator<GOMOKU_HEIGHT, GOMOKU_WIDTH> GomokuPatternEvaluator;
+	};
+};
\ No newline at end of file
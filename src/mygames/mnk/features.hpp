@@ -0,0 +1,89 @@
+#pragma once
+
+#include "../../game/game.hpp"
+#include "../../game/bits.hpp"
+#include "game.hpp"
+
+#include <cstdint>
+
+namespace AlphaYa
+{
+	namespace MNK
+	{
+		/*
+		Binary input features of m,n,k-game states for neural networks
+		Feature c is a stone of the player to move on cell c = i * width + j, and feature cells + c is a stone of the opponent,
+		so a position has one active feature per stone, and a move activates one feature of each perspective.
+		Outputs of policy are indexed by cell.
+		*/
+		template <typename StateType>
+		class MNKFeatures
+		{
+		public:
+			typedef StateType State;
+			typedef typename State::Data Data;
+			typedef typename State::Action Action;
+			typedef typename State::Row Row;
+
+			static constexpr IndexType height = State::board_height;
+			static constexpr IndexType width = State::board_width;
+			static constexpr IndexType cells = height * width;
+			static constexpr IndexType input_count = 2 * cells;
+			static constexpr IndexType output_count = cells;
+
+			/*
+			Symmetries of the board, 8 for square boards and 4 otherwise
+			Bit 0 of a symmetry flips rows, bit 1 flips columns and bit 2 transposes.
+			*/
+			static constexpr IndexType symmetry_count = height == width ? 8 : 4;
+
+			/*
+			Cell of (i, j) after symmetry
+			*/
+			static IndexType transform(IndexType symmetry, IndexType i, IndexType j)
+			{
+				if (symmetry & 1)
+				{
+					i = height - 1 - i;
+				}
+				if (symmetry & 2)
+				{
+					j = width - 1 - j;
+				}
+				return symmetry & 4 ? j * width + i : i * width + j;
+			}
+
+			static IndexType cell(const Action &action, IndexType symmetry = 0)
+			{
+				return transform(symmetry, action.row(), action.column());
+			}
+
+			static Action action(IndexType cell)
+			{
+				return Action(cell / width, cell % width);
+			}
+
+			/*
+			Write the active features of data after symmetry into features, and returns their number, at most cells
+			*/
+			static IndexType encode(const Data &data, IndexType symmetry, std::uint16_t features[])
+			{
+				const Row *own = data.side ? data.bitboard1 : data.bitboard0;
+				const Row *opponent = data.side ? data.bitboard0 : data.bitboard1;
+				IndexType count = 0;
+				for (IndexType i = 0; i < height; ++i)
+				{
+					for (std::uint64_t row = own[i]; row; row &= row - 1)
+					{
+						features[count++] = (std::uint16_t)transform(symmetry, i, lowest_bit(row));
+					}
+					for (std::uint64_t row = opponent[i]; row; row &= row - 1)
+					{
+						features[count++] = (std::uint16_t)(cells + transform(symmetry, i, lowest_bit(row)));
+					}
+				}
+				return count;
+			}
+		};
+	};
+};
\ No newline at end of file
@@ -0,0 +1,556 @@
+#pragma once
+
+#include "../../game/game.hpp"
+#include "../../game/bits.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace AlphaYa
+{
+	/*
+	m,n,k-game: two players alternately place stones on a height x width board,
+	and the first player to get win_length stones in a row wins.
+	See: https://en.wikipedia.org/wiki/M,n,k-game
+	*/
+	namespace MNK
+	{
+		/*
+		The narrowest unsigned integer type with at least bits bits
+		*/
+		template <IndexType bits>
+		class Word
+		{
+		public:
+			static_assert(bits <= 64, "Word should have at most 64 bits");
+			typedef typename std::conditional<
+				bits <= 8, std::uint8_t,
+				typename std::conditional<
+					bits <= 16, std::uint16_t,
+					typename std::conditional<bits <= 32, std::uint32_t, std::uint64_t>::type>::type>::type Type;
+		};
+
+		/*
+		Number of bits needed to represent numbers in [0, n)
+		*/
+		constexpr IndexType bit_width(IndexType n)
+		{
+			return n <= 1 ? 0 : 1 + bit_width((n + 1) >> 1);
+		}
+
+		/*
+		All data of game state
+		Row i of the board is a bitboard of width bits, bit j is column j.
+		See: https://www.chessprogramming.org/Bitboard_Board-Definition
+		*/
+		template <IndexType height, IndexType width>
+		class MNKData
+		{
+		public:
+			typedef typename Word<width>::Type Row;
+			Row bitboard0[height];
+			std::uint8_t side;
+			Row bitboard1[height];
+		};
+
+		/*
+		Game action
+		position is i << column_bits | j, for the cell at row i and column j
+		*/
+		template <IndexType height, IndexType width>
+		class MNKAction : public Action
+		{
+		public:
+			static constexpr IndexType column_bits = bit_width(width);
+			typedef typename Word<bit_width(height) + column_bits>::Type Position;
+
+			Position position;
+			MNKAction(Position p = 0) : position(p) {}
+			MNKAction(IndexType i, IndexType j) : position((Position)(i << column_bits | j)) {}
+
+			IndexType row() const
+			{
+				return position >> column_bits;
+			}
+			IndexType column() const
+			{
+				return position & ((((IndexType)1) << column_bits) - 1);
+			}
+
+			/*
+			Dense index of action, which is position
+			*/
+			IndexType index() const
+			{
+				return position;
+			}
+			static MNKAction fromIndex(IndexType index)
+			{
+				return MNKAction((Position)index);
+			}
+
+			/*
+			Output action as a short string to out, which does not contain endl
+			*/
+			void output(std::ostream &out) const
+			{
+				out << (char)('a' + column()) << (1 + row());
+			}
+
+			/*
+			Check if two actions are equal
+			*/
+			bool operator==(const MNKAction &o) const
+			{
+				return position == o.position;
+			}
+		};
+
+		/*
+		Undo information of a move, which is the winner before the move
+		*/
+		class MNKUndo
+		{
+		public:
+			std::uint8_t winner;
+		};
+
+		/*
+		Random keys of Zobrist hashing, for a stone of each player on each cell, and for O to move
+		See: https://www.chessprogramming.org/Zobrist_Hashing
+		*/
+		template <IndexType height, IndexType width>
+		class ZobristKeys
+		{
+		public:
+			std::uint64_t stones[2][height][width];
+			std::uint64_t side;
+
+			/*
+			Keys are generated by SplitMix64 from a fixed seed, so that hashes are the same in every run
+			*/
+			ZobristKeys()
+			{
+				std::uint64_t seed = 0x416C70686159612EULL;
+				const auto next = [&seed]()
+				{
+					std::uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+					z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+					z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+					return z ^ (z >> 31);
+				};
+				for (IndexType player = 0; player < 2; ++player)
+				{
+					for (IndexType i = 0; i < height; ++i)
+					{
+						for (IndexType j = 0; j < width; ++j)
+						{
+							stones[player][i][j] = next();
+						}
+					}
+				}
+				side = next();
+			}
+
+			static const ZobristKeys &get()
+			{
+				static const ZobristKeys keys;
+				return keys;
+			}
+		};
+
+		/*
+		Game state
+		Template arguments are: <board height, board width, number of stones in a row to win>.
+		Besides data, the state keeps its hash, winner and number of stones,
+		which are updated incrementally by move and undo, and recomputed from data by refresh.
+		*/
+		template <IndexType height, IndexType width, IndexType win_length>
+		class MNKState : public State<2, MNKData<height, width>, MNKAction<height, width>>
+		{
+		public:
+			static_assert(height >= 1, "height should be at least 1");
+			static_assert(width >= 1 && width <= 64, "width should be in [1, 64]");
+			static_assert(win_length >= 1 && (win_length <= height || win_length <= width), "win_length should fit in the board");
+
+			typedef MNKData<height, width> Data;
+			typedef MNKAction<height, width> Action;
+			typedef typename Data::Row Row;
+			typedef MNKUndo Undo;
+			typedef ZobristKeys<height, width> Keys;
+
+			static constexpr IndexType board_height = height;
+			static constexpr IndexType board_width = width;
+			static constexpr IndexType board_win_length = win_length;
+			static constexpr Row full_row = (Row)((Row)(~(Row)0) >> (8 * sizeof(Row) - width));
+			static constexpr IndexType action_count = height << Action::column_bits;
+			typedef BitSet<action_count> ActionSet;
+
+			/*
+			key is the Zobrist hash of data, winner is 0 if no player has a line, or 1 + the player with a line,
+			and stone_count is the number of stones on the board
+			*/
+			std::uint64_t key;
+			std::uint8_t winner;
+			std::uint16_t stone_count;
+			static_assert(height * width < 65536, "the number of stones should fit in 16 bits");
+
+			/*
+			Returns id of the current player
+			*/
+			IndexType toMove() const
+			{
+				const Data &data = this->getData();
+				return data.side;
+			}
+
+			/*
+			Returns actions that the current can make
+			*/
+			std::vector<Action> generateActions() const
+			{
+				const Data &data = this->getData();
+				std::vector<Action> actions;
+				actions.reserve(width * height);
+				for (IndexType i = 0; i < height; ++i)
+				{
+					for (Row empty = full_row & ~(data.bitboard0[i] | data.bitboard1[i]); empty; empty &= empty - 1)
+					{
+						actions.emplace_back(i, lowest_bit(empty));
+					}
+				}
+				return actions;
+			}
+
+			/*
+			Returns actions that the current can make as a set of action indices
+			Row i occupies bits [i << column_bits, (i << column_bits) + width) of the set.
+			*/
+			void generateActionSet(ActionSet &actions) const
+			{
+				const Data &data = this->getData();
+				actions.clear();
+				for (IndexType i = 0; i < height; ++i)
+				{
+					const IndexType offset = i << Action::column_bits;
+					actions.words[offset >> 6] |= ((std::uint64_t)(Row)(full_row & ~(data.bitboard0[i] | data.bitboard1[i]))) << (offset & 63);
+				}
+			}
+
+			/*
+			Modifies the data according to action
+			Returns the information needed to undo the move.
+			*/
+			Undo move(const Action &action)
+			{
+				Data &data = this->getData();
+				const Keys &keys = Keys::get();
+				const Undo undo = {winner};
+				const IndexType i = action.row(), j = action.column();
+				const Row mask = (Row)(((Row)1) << j);
+				Row *bitboard = data.side ? data.bitboard1 : data.bitboard0;
+				bitboard[i] |= mask;
+				key ^= keys.stones[data.side][i][j] ^ keys.side;
+				++stone_count;
+				if (!winner && makesLine(bitboard, i, j))
+				{
+					winner = (std::uint8_t)(data.side + 1);
+				}
+				data.side ^= 1;
+				return undo;
+			}
+
+			/*
+			Take back action, which should be the last move, with the information returned by its move
+			*/
+			void undo(const Action &action, const Undo &undo)
+			{
+				Data &data = this->getData();
+				const Keys &keys = Keys::get();
+				data.side ^= 1;
+				const IndexType i = action.row(), j = action.column();
+				const Row mask = (Row)(((Row)1) << j);
+				(data.side ? data.bitboard1 : data.bitboard0)[i] &= (Row)~mask;
+				key ^= keys.stones[data.side][i][j] ^ keys.side;
+				--stone_count;
+				winner = undo.winner;
+			}
+
+			/*
+			Zobrist hash of the state, equal states have equal hashes
+			*/
+			std::uint64_t hash() const
+			{
+				return key;
+			}
+
+			/*
+			Check if the stone at (i, j) is in a line of win_length stones on bitboard
+			Cell t of each line through (i, j) is bit t + win_length - 1 of a word, for t in (-win_length, win_length),
+			so that the line is found by shifting and masking the 4 words like hasLine.
+			Boards with at most 2 * win_length - 1 rows are checked as a whole by hasLine, which is cheaper there.
+			*/
+			static bool makesLine(const Row bitboard[height], IndexType i, IndexType j)
+			{
+				static_assert(win_length <= 32, "lines through a cell should fit in 64 bits");
+				constexpr int reach = (int)win_length - 1;
+				if (height <= 2 * win_length - 1)
+				{
+					return hasLine(bitboard);
+				}
+				const std::uint64_t row = bitboard[i];
+				std::uint64_t lines[4] = {(j >= (IndexType)reach ? row >> (j - reach) : row << (reach - j)) & ((((std::uint64_t)1) << (2 * reach + 1)) - 1), 0, 0, 0};
+				for (int t = -reach; t <= reach; ++t)
+				{
+					const int ti = (int)i + t;
+					if (ti < 0 || ti >= (int)height)
+					{
+						continue;
+					}
+					const std::uint64_t cells = bitboard[ti];
+					const int diagonal_j = (int)j + t, anti_diagonal_j = (int)j - t;
+					lines[1] |= (cells >> j & 1) << (t + reach);
+					if (diagonal_j >= 0 && diagonal_j < (int)width)
+					{
+						lines[2] |= (cells >> diagonal_j & 1) << (t + reach);
+					}
+					if (anti_diagonal_j >= 0 && anti_diagonal_j < (int)width)
+					{
+						lines[3] |= (cells >> anti_diagonal_j & 1) << (t + reach);
+					}
+				}
+				for (IndexType d = 0; d < 4; ++d)
+				{
+					std::uint64_t line = lines[d];
+					for (IndexType t = 1; t < win_length; ++t)
+					{
+						line &= lines[d] >> t;
+					}
+					if (line)
+					{
+						return true;
+					}
+				}
+				return false;
+			}
+
+			/*
+			Check if there are win_length stones in a row on bitboard
+			Bit j of horizontal (vertical, diagonal, anti_diagonal) is set
+			if the line of win_length cells starting at (i, j) is full.
+			*/
+			static bool hasLine(const Row bitboard[height])
+			{
+				for (IndexType i = 0; i < height; ++i)
+				{
+					Row horizontal = bitboard[i];
+					for (IndexType t = 1; t < win_length; ++t)
+					{
+						horizontal &= (Row)(bitboard[i] >> t);
+					}
+					if (horizontal)
+					{
+						return true;
+					}
+				}
+				for (IndexType i = 0; i + win_length <= height; ++i)
+				{
+					Row vertical = bitboard[i], diagonal = bitboard[i], anti_diagonal = bitboard[i];
+					for (IndexType t = 1; t < win_length; ++t)
+					{
+						vertical &= bitboard[i + t];
+						diagonal &= (Row)(bitboard[i + t] >> t);
+						anti_diagonal &= (Row)(bitboard[i + t] << t);
+					}
+					if (vertical | diagonal | anti_diagonal)
+					{
+						return true;
+					}
+				}
+				return false;
+			}
+
+			/*
+			Calculate score if game over
+			If game is over, write the score of each player into scores, and return true.
+			If game is not over, do not modify scores, and return false.
+			*/
+			bool calculateScore(ScoreType scores[2]) const
+			{
+				if (winner)
+				{
+					scores[0] = winner == 1 ? 1 : -1;
+					scores[1] = -scores[0];
+					return true;
+				}
+				if (stone_count < height * width)
+				{
+					return false;
+				}
+				scores[0] = 0;
+				scores[1] = 0;
+				return true;
+			}
+
+			/*
+			Clear the board, and X moves first
+			Padding bytes are cleared too, so that equal states have equal bytes.
+			*/
+			void clear()
+			{
+				std::memset(this->getBytes(), 0, this->byte_count);
+				key = 0;
+				winner = 0;
+				stone_count = 0;
+			}
+
+			/*
+			Recompute key, winner and stone_count from data, after data is modified directly
+			If both players have a line, X is the winner.
+			*/
+			void refresh()
+			{
+				const Data &data = this->getData();
+				const Keys &keys = Keys::get();
+				key = data.side ? keys.side : 0;
+				stone_count = 0;
+				for (IndexType i = 0; i < height; ++i)
+				{
+					for (IndexType j = 0; j < width; ++j)
+					{
+						if (data.bitboard0[i] >> j & 1)
+						{
+							key ^= keys.stones[0][i][j];
+							++stone_count;
+						}
+						else if (data.bitboard1[i] >> j & 1)
+						{
+							key ^= keys.stones[1][i][j];
+							++stone_count;
+						}
+					}
+				}
+				winner = hasLine(data.bitboard0) ? 1 : hasLine(data.bitboard1) ? 2 : 0;
+			}
+
+			/*
+			Init the game state from ANY string
+			Format: [XM|OM] (X|O|+ <column letter> <row number>)*
+			*/
+			void init(const std::string &state_string)
+			{
+				Data &data = this->getData();
+				clear();
+
+				std::string argument;
+				for (std::istringstream ssin(state_string);;)
+				{
+					ssin >> argument;
+					if (ssin.fail())
+					{
+						break;
+					}
+					if (argument == "XM")
+					{
+						data.side = 0;
+						continue;
+					}
+					if (argument == "OM")
+					{
+						data.side = 1;
+						continue;
+					}
+					if (argument == "X" || argument == "O" || argument == "+")
+					{
+						std::string a;
+						IndexType b;
+						ssin >> a >> b;
+						if (ssin.fail() || a.length() != 1 || a[0] < 'a' || a[0] >= 'a' + ((char)width) || !b || b > height)
+						{
+							break;
+						}
+						--b;
+						const Row mask = (Row)(((Row)1) << (a[0] - 'a'));
+						if (argument == "X")
+						{
+							data.bitboard0[b] |= mask;
+						}
+						else
+						{
+							data.bitboard0[b] &= (Row)(~mask);
+						}
+						if (argument == "O")
+						{
+							data.bitboard1[b] |= mask;
+						}
+						else
+						{
+							data.bitboard1[b] &= (Row)(~mask);
+						}
+						continue;
+					}
+				}
+				refresh();
+			}
+
+			/*
+			Output the game state to out using method
+			The possible methods are:
+			terminal: output pretty-printed board
+			(other value): output a short string, which does not contain endl, and can be read by init(std::string)
+			*/
+			void output(std::ostream &out, const std::string &method) const
+			{
+				const Data &data = this->getData();
+				if (method == "terminal")
+				{
+					for (IndexType i = height - 1; ~i; --i)
+					{
+						out << "\033[0;37;90m" << std::setw(2) << (i + 1) << "\033[0m \033[30;43;103;48;5;214m ";
+						for (IndexType j = 0; j < width; ++j)
+						{
+							if (data.bitboard0[i] >> j & 1)
+							{
+								out << "X ";
+							}
+							else if (data.bitboard1[i] >> j & 1)
+							{
+								out << "\033[37;97;38;5;231;38;2;255;255;255mO\033[30m ";
+							}
+							else
+							{
+								out << "\033[38;5;208;38;2;255;135;0m+\033[30m ";
+							}
+						}
+						out << "\033[0m" << std::endl;
+					}
+					out << "\033[0;37;90m    ";
+					for (IndexType j = 0; j < width; ++j)
+					{
+						out << (char)('a' + j) << " ";
+					}
+					out << "\033[0m" << std::endl;
+					return;
+				}
+				out << (data.side ? "OM " : "XM ");
+				for (IndexType i = 0; i < height; ++i)
+				{
+					const Row bitboard1_i = data.bitboard1[i];
+					const Row bitboard_i = bitboard1_i | data.bitboard0[i];
+					for (IndexType j = 0; j < width; ++j)
+					{
+						if (bitboard_i >> j & 1)
+						{
+							out << ((bitboard1_i >> j & 1) ? "O " : "X ") << (char)('a' + j) << " " << (1 + i) << " ";
+						}
+					}
+				}
+			}
+		};
+	};
+};
\ No newline at end of file
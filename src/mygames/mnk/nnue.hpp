@@ -0,0 +1,157 @@
+#pragma once
+
+#include "../../game/game.hpp"
+#include "../../agent/heuristic.hpp"
+#include "../../nn/quantized.hpp"
+#include "features.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace AlphaYa
+{
+	namespace MNK
+	{
+		/*
+		Efficiently updatable evaluator of m,n,k-game states by a network trained on MNKFeatures
+		An accumulator of the first layer is kept for both perspectives: the accumulator of player p
+		is the sum of the columns of the stones of p as own stones and of the opponent as opposing stones.
+		A move adds one column to each accumulator, so the first layer costs two 16-bit vector additions
+		per move, and evaluation only runs the small layers above it from the accumulator of the player to move.
+		Priors are the exponentials of policy logits over empty cells relative to the largest, so in (0, 1],
+		computed for all cells at the first prior of a position, since search asks for all untried actions at once.
+		See: https://www.chessprogramming.org/NNUE
+		*/
+		template <typename StateType>
+		class MNKNNUEEvaluator : public Heuristic<StateType>
+		{
+		public:
+			typedef StateType State;
+			typedef typename State::Action Action;
+			typedef typename State::Data Data;
+			typedef MNKFeatures<State> Features;
+			typedef Heuristic<State> Base;
+
+			static constexpr IndexType cells = Features::cells;
+			static constexpr IndexType word_count = (cells + 63) / 64;
+
+			std::shared_ptr<const NN::QuantizedNetwork> network;
+
+			/*
+			Accumulators of X and O, hidden_width each
+			*/
+			std::vector<std::int16_t> accumulators;
+
+			std::uint64_t occupied[word_count];
+			IndexType side;
+
+			/*
+			Buffers of evaluation, and priors of the current position if priors_valid
+			*/
+			mutable std::vector<std::int16_t> hidden, value_hidden;
+			mutable std::vector<float> priors;
+			mutable bool priors_valid;
+
+			/*
+			network should be quantized from a network with Features::input_count inputs and Features::output_count outputs
+			*/
+			MNKNNUEEvaluator(const std::shared_ptr<const NN::QuantizedNetwork> &n) : network(n), accumulators(2 * n->hidden_width), side(0), hidden(n->hidden_width), value_hidden(n->value_hidden_width), priors(cells), priors_valid(false)
+			{
+				std::fill(occupied, occupied + word_count, 0);
+			}
+
+			/*
+			Quantized network of the weight file at path, or an empty pointer if it does not fit the features
+			*/
+			static std::shared_ptr<const NN::QuantizedNetwork> load(const std::string &path)
+			{
+				std::shared_ptr<NN::QuantizedNetwork> n = std::make_shared<NN::QuantizedNetwork>();
+				if (!n->load(path, cells) || n->input_count != Features::input_count || n->output_count != Features::output_count)
+				{
+					return std::shared_ptr<const NN::QuantizedNetwork>();
+				}
+				return n;
+			}
+
+			std::unique_ptr<Base> clone() const
+			{
+				return std::unique_ptr<Base>(new MNKNNUEEvaluator(*this));
+			}
+
+			void assign(const Base &other)
+			{
+				const MNKNNUEEvaluator &evaluator = static_cast<const MNKNNUEEvaluator &>(other);
+				std::copy(evaluator.accumulators.begin(), evaluator.accumulators.end(), accumulators.begin());
+				std::copy(evaluator.occupied, evaluator.occupied + word_count, occupied);
+				side = evaluator.side;
+				priors_valid = false;
+			}
+
+			void init(const State &state)
+			{
+				const Data &data = state.getData();
+				const IndexType width = network->hidden_width;
+				std::int16_t *own = accumulators.data() + data.side * width;
+				std::int16_t *opponent = accumulators.data() + (data.side ^ 1) * width;
+				network->reset(own);
+				network->reset(opponent);
+				std::fill(occupied, occupied + word_count, 0);
+				std::uint16_t features[cells];
+				const IndexType count = Features::encode(data, 0, features);
+				for (IndexType k = 0; k < count; ++k)
+				{
+					const IndexType f = features[k];
+					network->add(own, f);
+					network->add(opponent, f < cells ? f + cells : f - cells);
+					occupied[f % cells >> 6] |= (std::uint64_t)1 << (f % cells & 63);
+				}
+				side = data.side;
+				priors_valid = false;
+			}
+
+			void move(const Action &action)
+			{
+				const IndexType cell = Features::cell(action);
+				const IndexType width = network->hidden_width;
+				network->add(accumulators.data() + side * width, cell);
+				network->add(accumulators.data() + (side ^ 1) * width, cells + cell);
+				occupied[cell >> 6] |= (std::uint64_t)1 << (cell & 63);
+				side ^= 1;
+				priors_valid = false;
+			}
+
+			float prior(const Action &action) const
+			{
+				if (!priors_valid)
+				{
+					network->activate(accumulators.data() + side * network->hidden_width, hidden.data());
+					float largest = -INFINITY;
+					for (IndexType o = 0; o < cells; ++o)
+					{
+						if (!(occupied[o >> 6] >> (o & 63) & 1))
+						{
+							priors[o] = network->logit(hidden.data(), o);
+							largest = std::max(largest, priors[o]);
+						}
+					}
+					for (IndexType o = 0; o < cells; ++o)
+					{
+						priors[o] = occupied[o >> 6] >> (o & 63) & 1 ? 0.0f : std::max(std::exp(priors[o] - largest), 1e-6f);
+					}
+					priors_valid = true;
+				}
+				return priors[Features::cell(action)];
+			}
+
+			float evaluate() const
+			{
+				network->activate(accumulators.data() + side * network->hidden_width, hidden.data());
+				return network->value(hidden.data(), value_hidden.data());
+			}
+		};
+	};
+};
\ No newline at end of file
@@ -0,0 +1,209 @@
+#pragma once
+
+#include "../../game/game.hpp"
+#include "../../agent/playout.hpp"
+#include "game.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ALPHAYA_PLAYOUT_SSE
+#include <emmintrin.h>
+#endif
+
+namespace AlphaYa
+{
+	namespace MNK
+	{
+		/*
+		Random playouts of lanes games at once, one game in every byte lane of SIMD registers
+		A random game fills the empty cells in a random order, so each lane takes a random permutation of empty cells,
+		and stamps every cell with the time it is filled, so that the player who fills it follows from the parity of its time.
+		The winner is the player of the line which is completed first,
+		where a line is completed at the maximum time of its cells if all its cells belong to one player.
+		Times of all lanes are compared together, so the lines of the board are checked for lanes games at the cost of one.
+		*/
+		template <typename StateType>
+		class MNKPlayout : public Playout<StateType>
+		{
+		public:
+			typedef StateType State;
+			typedef typename State::Data Data;
+
+			static constexpr IndexType height = State::board_height;
+			static constexpr IndexType width = State::board_width;
+			static constexpr IndexType win_length = State::board_win_length;
+			static constexpr IndexType cells = height * width;
+			static constexpr IndexType lanes = 16;
+			static_assert(cells < 255, "times of cells should fit in a byte below 255");
+
+			/*
+			times[c][l] is the time cell c is filled in lane l, 0 for stones already on the board
+			xs[c][l] is 0xFF if cell c belongs to X in lane l, and 0 if it belongs to O
+			*/
+			std::uint8_t times[cells][lanes];
+			std::uint8_t xs[cells][lanes];
+
+			/*
+			Cells of every line of win_length cells, line after line
+			*/
+			std::vector<std::uint8_t> lines;
+
+			std::uint64_t random_state;
+
+			MNKPlayout(std::uint64_t seed)
+			{
+				random_state = seed * 0x9E3779B97F4A7C15ULL | 1;
+				static const int steps[4][2] = {{0, 1}, {1, 0}, {1, 1}, {1, -1}};
+				for (IndexType d = 0; d < 4; ++d)
+				{
+					for (int i = 0; i < (int)height; ++i)
+					{
+						for (int j = 0; j < (int)width; ++j)
+						{
+							const int end_i = i + steps[d][0] * ((int)win_length - 1), end_j = j + steps[d][1] * ((int)win_length - 1);
+							if (end_i < 0 || end_i >= (int)height || end_j < 0 || end_j >= (int)width)
+							{
+								continue;
+							}
+							for (int t = 0; t < (int)win_length; ++t)
+							{
+								lines.push_back((std::uint8_t)((i + t * steps[d][0]) * (int)width + j + t * steps[d][1]));
+							}
+						}
+					}
+				}
+			}
+
+			/*
+			xorshift64*, which is much cheaper than std::mt19937 for shuffling
+			See: https://en.wikipedia.org/wiki/Xorshift#xorshift*
+			*/
+			std::uint32_t random()
+			{
+				random_state ^= random_state >> 12;
+				random_state ^= random_state << 25;
+				random_state ^= random_state >> 27;
+				return (std::uint32_t)((random_state * 0x2545F4914F6CDD1DULL) >> 32);
+			}
+
+			/*
+			Uniform integer in [0, n), see: https://arxiv.org/abs/1805.10941
+			*/
+			IndexType below(IndexType n)
+			{
+				return (IndexType)(((std::uint64_t)random() * n) >> 32);
+			}
+
+			/*
+			Play lanes games from state, and write the winner of every lane into winners:
+			0 for X, 1 for O and 2 for a draw
+			*/
+			void playBatch(const State &state, std::uint8_t winners[lanes])
+			{
+				const Data &data = state.getData();
+				std::uint8_t empties[cells], order[cells];
+				IndexType empty_count = 0;
+				for (IndexType i = 0; i < height; ++i)
+				{
+					for (IndexType j = 0; j < width; ++j)
+					{
+						const IndexType c = i * width + j;
+						if (data.bitboard0[i] >> j & 1)
+						{
+							std::memset(times[c], 0, lanes);
+							std::memset(xs[c], 0xFF, lanes);
+						}
+						else if (data.bitboard1[i] >> j & 1)
+						{
+							std::memset(times[c], 0, lanes);
+							std::memset(xs[c], 0, lanes);
+						}
+						else
+						{
+							empties[empty_count++] = (std::uint8_t)c;
+						}
+					}
+				}
+				const std::uint8_t first = state.toMove() ? 0 : 0xFF;
+				for (IndexType l = 0; l < lanes; ++l)
+				{
+					std::memcpy(order, empties, empty_count);
+					for (IndexType t = 0; t < empty_count; ++t)
+					{
+						const IndexType k = t + below(empty_count - t);
+						const std::uint8_t c = order[k];
+						order[k] = order[t];
+						times[c][l] = (std::uint8_t)(t + 1);
+						xs[c][l] = (t & 1) ? (std::uint8_t)~first : first;
+					}
+				}
+
+				// Earliest completion time of a line of X and O in every lane, 0xFF if none
+				std::uint8_t best[2][lanes];
+#ifdef ALPHAYA_PLAYOUT_SSE
+				const __m128i none = _mm_set1_epi8((char)0xFF);
+				__m128i best_x = none, best_o = none;
+				for (IndexType start = 0; start < lines.size(); start += win_length)
+				{
+					const std::uint8_t *line = &lines[start];
+					__m128i time = _mm_loadu_si128((const __m128i *)times[line[0]]);
+					__m128i all_x = _mm_loadu_si128((const __m128i *)xs[line[0]]);
+					__m128i any_x = all_x;
+					for (IndexType t = 1; t < win_length; ++t)
+					{
+						const __m128i x = _mm_loadu_si128((const __m128i *)xs[line[t]]);
+						time = _mm_max_epu8(time, _mm_loadu_si128((const __m128i *)times[line[t]]));
+						all_x = _mm_and_si128(all_x, x);
+						any_x = _mm_or_si128(any_x, x);
+					}
+					best_x = _mm_min_epu8(best_x, _mm_or_si128(time, _mm_xor_si128(all_x, none)));
+					best_o = _mm_min_epu8(best_o, _mm_or_si128(time, any_x));
+				}
+				_mm_storeu_si128((__m128i *)best[0], best_x);
+				_mm_storeu_si128((__m128i *)best[1], best_o);
+#else
+				std::memset(best, 0xFF, sizeof(best));
+				for (IndexType start = 0; start < lines.size(); start += win_length)
+				{
+					const std::uint8_t *line = &lines[start];
+					for (IndexType l = 0; l < lanes; ++l)
+					{
+						std::uint8_t time = times[line[0]][l], all_x = xs[line[0]][l], any_x = all_x;
+						for (IndexType t = 1; t < win_length; ++t)
+						{
+							time = time > times[line[t]][l] ? time : times[line[t]][l];
+							all_x &= xs[line[t]][l];
+							any_x |= xs[line[t]][l];
+						}
+						const std::uint8_t time_x = time | (std::uint8_t)~all_x, time_o = time | any_x;
+						best[0][l] = best[0][l] < time_x ? best[0][l] : time_x;
+						best[1][l] = best[1][l] < time_o ? best[1][l] : time_o;
+					}
+				}
+#endif
+				for (IndexType l = 0; l < lanes; ++l)
+				{
+					winners[l] = best[0][l] < best[1][l] ? 0 : best[1][l] < best[0][l] ? 1 : 2;
+				}
+			}
+
+			IndexType play(const State &state, ScoreType totals[2])
+			{
+				std::uint8_t winners[lanes];
+				playBatch(state, winners);
+				for (IndexType l = 0; l < lanes; ++l)
+				{
+					if (winners[l] < 2)
+					{
+						totals[winners[l]] += 1;
+						totals[winners[l] ^ 1] -= 1;
+					}
+				}
+				return lanes;
+			}
+		};
+	};
+};
\ No newline at end of file
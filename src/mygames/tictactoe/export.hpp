@@ -1,176 +1,358 @@
-#pragma once
-
-#include "../../game/game.hpp"
-#include "../../agent/agent.hpp"
-#include "../../agent/agent_input.hpp"
-#include "../../agent/agent_random.hpp"
-#include "../../agent/agent_mcts.hpp"
-#include "game.hpp"
-
-#include <functional>
-#include <memory>
-#include <sstream>
-#include <string>
-#include <vector>
-
-namespace AlphaYaExport
-{
-	using AlphaYa::IndexType;
-	using AlphaYa::ScoreType;
-	// Game data
-	typedef AlphaYa::TicTacToe::TicTacToeData Data;
-	// Game state
-	typedef AlphaYa::TicTacToe::TicTacToeState State;
-	// Game action
-	typedef AlphaYa::TicTacToe::TicTacToeAction Action;
-	typedef AlphaYa::Agent<State> Agent;
-	typedef AlphaYa::InputAgent<State> InputAgent;
-	typedef AlphaYa::RandomAgent<State> RandomAgent;
-	typedef AlphaYa::MCTSAgent<State> MCTSAgent;
-
-	constexpr IndexType players = State::players;
-
-	class AgentConstructor
-	{
-	public:
-		std::string name;
-		std::string description;
-		std::function<std::unique_ptr<Agent>(const std::string &)> constructor;
-		bool need_config;
-		AgentConstructor(
-			const std::string &n,
-			const std::string &d,
-			const std::function<std::unique_ptr<Agent>(const std::string &)> &c,
-			bool nc = false) : name(n), description(d), constructor(c), need_config(nc) {}
-	};
-
-	/*
-	Input agent: read action from input
-	*/
-	std::unique_ptr<Agent> input_agent(const std::string &config)
-	{
-		return std::make_unique<InputAgent>();
-	}
-
-	/*
-	Random agent: randomly move
-	*/
-	std::unique_ptr<Agent> random_agent(const std::string &config)
-	{
-		RandomAgent::SeedType seed = 42;
-		std::string argument;
-		for (std::istringstream cfin(config);;)
-		{
-			cfin >> argument;
-			if (cfin.fail())
-			{
-				break;
-			}
-			if (argument == "seed")
-			{
-				cfin >> seed;
-				continue;
-			}
-		}
-		return std::make_unique<RandomAgent>(seed);
-	}
-
-	/*
-	MCTS agent: use MCTS algorithm
-	*/
-	std::unique_ptr<Agent> mcts_agent(const std::string &config)
-	{
-		MCTSAgent::SeedType seed = 42;
-		MCTSAgent::EvalType c = 1.0;
-		IndexType simulate_count = 1000000;
-		IndexType log_interval = 100000;
-		std::string argument;
-		for (std::istringstream cfin(config);;)
-		{
-			cfin >> argument;
-			if (cfin.fail())
-			{
-				break;
-			}
-			if (argument == "seed")
-			{
-				cfin >> seed;
-				continue;
-			}
-			if (argument == "c")
-			{
-				cfin >> c;
-				continue;
-			}
-			if (argument == "scount")
-			{
-				cfin >> simulate_count;
-				continue;
-			}
-			if (argument == "loginterval")
-			{
-				cfin >> log_interval;
-				continue;
-			}
-		}
-		return std::make_unique<MCTSAgent>(seed, c, simulate_count, log_interval);
-	}
-
-	/*
-	Agent constructors
-	Format: AgentConstructor("name", "description", constructor, needconfig(bool))
-	*/
-	const AgentConstructor agent_constructors[] = {
-		AgentConstructor("human", "You", input_agent),
-		AgentConstructor("random", "Randomly moving bot", random_agent, true),
-		AgentConstructor("ai", "AI using MCTS algorithm", mcts_agent, true),
-	};
-
-	/*
-	Names of players
-	*/
-	const std::string player_names[players] = {"X", "O"};
-
-	/*
-	If allow_customize_state = true, user would be able to input a string as the initial state
-	*/
-	constexpr bool allow_customize_state = false;
-
-	/*
-	If allow_customize_state = true, default_state is the default initial state
-	If allow_customize_state = false, default_state is the only possible initial state
-	*/
-	const std::string default_state = "";
-
-	/*
-	Controls whether agent for each player can be customized
-	*/
-	const bool allow_customize_agents[players] = {true, true};
-
-	/*
-	The default agent for each player
-	*/
-	const std::string default_agents[players] = {"ai", "human"};
-
-	/*
-	The default agent config for each player
-	*/
-	const std::string default_agent_config[players] = {"", ""};
-
-	/*
-	Help string
-	This string will be printed when user executes ".help" command.
-	Please put the game's name, rule author, programmer and rule into this string.
-	Please use English if possible.
-	*/
-	const std::string help = "Tic-Tac-Toe\n"
-							 "Code: Ya\n"
-							 "\n"
-							 "Classic tic-tac-toe game.\n";
-
-	/*
-	Record file prefix
-	Record files will be saved as records/<prefix>_<time>.txt
-	*/
-	const std::string record_prefix = "tictactoe";
+#pragma once
+
+#include "../../game/game.hpp"
+#include "../../agent/agent.hpp"
+#include "../../agent/agent_input.hpp"
+#include "../../agent/agent_random.hpp"
+#include "../../agent/agent_mcts.hpp"
+#include "../../agent/agent_mcts_compact.hpp"
+#include "../../agent/agent_solver.hpp"
+#include "../mnk/features.hpp"
+#include "../mnk/playout.hpp"
+#include "game.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace AlphaYaExport
+{
+	using AlphaYa::IndexType;
+	using AlphaYa::ScoreType;
+	using AlphaYa::StopToken;
+	// Game data
+	typedef AlphaYa::TicTacToe::TicTacToeData Data;
+	// Game state
+	typedef AlphaYa::TicTacToe::TicTacToeState State;
+	// Game action
+	typedef AlphaYa::TicTacToe::TicTacToeAction Action;
+	typedef AlphaYa::Agent<State> Agent;
+	typedef AlphaYa::InputAgent<State> InputAgent;
+	typedef AlphaYa::RandomAgent<State> RandomAgent;
+	typedef AlphaYa::MCTSAgent<State> MCTSAgent;
+	typedef AlphaYa::CompactMCTSAgent<State> CompactMCTSAgent;
+	typedef AlphaYa::SolverAgent<State> SolverAgent;
+	// Input features of networks
+	typedef AlphaYa::MNK::MNKFeatures<State> Features;
+
+	constexpr IndexType players = State::players;
+
+	class AgentConstructor
+	{
+	public:
+		std::string name;
+		std::string description;
+		std::function<std::unique_ptr<Agent>(const std::string &)> constructor;
+		bool need_config;
+		AgentConstructor(
+			const std::string &n,
+			const std::string &d,
+			const std::function<std::unique_ptr<Agent>(const std::string &)> &c,
+			bool nc = false) : name(n), description(d), constructor(c), need_config(nc) {}
+	};
+
+	/*
+	Input agent: read action from input
+	*/
+	std::unique_ptr<Agent> input_agent(const std::string &config)
+	{
+		return std::make_unique<InputAgent>();
+	}
+
+	/*
+	Random agent: randomly move
+	*/
+	std::unique_ptr<Agent> random_agent(const std::string &config)
+	{
+		RandomAgent::SeedType seed = 42;
+		std::string argument;
+		for (std::istringstream cfin(config);;)
+		{
+			cfin >> argument;
+			if (cfin.fail())
+			{
+				break;
+			}
+			if (argument == "seed")
+			{
+				cfin >> seed;
+				continue;
+			}
+		}
+		return std::make_unique<RandomAgent>(seed);
+	}
+
+	/*
+	MCTS agent: use MCTS algorithm
+	compact 1: use compact nodes, which do not store states
+	ponder 1: keep searching during the opponent's turn, using at most pondermemory MB
+	rave k: blend AMAF statistics into child values with equivalence parameter k
+	maxmemory MB: evict low-visit subtrees when the tree uses more than MB megabytes, 0 for no limit
+	checkpoint PATH: load the tree from PATH before the first move if it exists, and save it to PATH every checkpointinterval (default 10) moves and at exit
+	gumbel m: sample m root actions and split simulations among them by sequential halving, 0 to use UCB at the root
+	playout 1: stop simulations at new leaves, and evaluate them by batches of 16 random playouts in SIMD lanes
+	movetime MS: stop searching a move after MS milliseconds, 0 for no limit
+	compaction 1: relocate the reused tree into contiguous memory in visit order at every move, and while pondering
+	trace PATH: record an event of every simulation into a ring buffer of tracesize events, and append it to PATH after every move and when the agent is destroyed
+	Words of config which are neither keys nor their values are appended to unknown.
+	With compact 1, only seed, c, scount and loginterval are used, and the other keys are reported and appended to unknown.
+	*/
+	std::unique_ptr<Agent> configure_mcts_agent(const std::string &config, std::vector<std::string> &unknown)
+	{
+		MCTSAgent::SeedType seed = 42;
+		MCTSAgent::EvalType c = 1.0;
+		IndexType simulate_count = 1000000;
+		IndexType log_interval = 100000;
+		bool compact = false;
+		bool ponder = false;
+		IndexType ponder_memory = 1024;
+		MCTSAgent::EvalType rave = 0.0;
+		IndexType max_memory = 0;
+		std::string checkpoint;
+		IndexType checkpoint_interval = 10;
+		IndexType gumbel_count = 0;
+		bool use_playout = false;
+		IndexType move_time = 0;
+		bool compaction = false;
+		std::string trace;
+		IndexType trace_size = 1 << 20;
+		std::vector<std::string> keys;
+		std::string argument;
+		for (std::istringstream cfin(config);;)
+		{
+			cfin >> argument;
+			if (cfin.fail())
+			{
+				break;
+			}
+			keys.push_back(argument);
+			if (argument == "seed")
+			{
+				cfin >> seed;
+				continue;
+			}
+			if (argument == "c")
+			{
+				cfin >> c;
+				continue;
+			}
+			if (argument == "scount")
+			{
+				cfin >> simulate_count;
+				continue;
+			}
+			if (argument == "loginterval")
+			{
+				cfin >> log_interval;
+				continue;
+			}
+			if (argument == "compact")
+			{
+				cfin >> compact;
+				continue;
+			}
+			if (argument == "ponder")
+			{
+				cfin >> ponder;
+				continue;
+			}
+			if (argument == "pondermemory")
+			{
+				cfin >> ponder_memory;
+				continue;
+			}
+			if (argument == "rave")
+			{
+				cfin >> rave;
+				continue;
+			}
+			if (argument == "maxmemory")
+			{
+				cfin >> max_memory;
+				continue;
+			}
+			if (argument == "checkpoint")
+			{
+				cfin >> checkpoint;
+				continue;
+			}
+			if (argument == "checkpointinterval")
+			{
+				cfin >> checkpoint_interval;
+				continue;
+			}
+			if (argument == "gumbel")
+			{
+				cfin >> gumbel_count;
+				continue;
+			}
+			if (argument == "playout")
+			{
+				cfin >> use_playout;
+				continue;
+			}
+			if (argument == "movetime")
+			{
+				cfin >> move_time;
+				continue;
+			}
+			if (argument == "compaction")
+			{
+				cfin >> compaction;
+				continue;
+			}
+			if (argument == "trace")
+			{
+				cfin >> trace;
+				continue;
+			}
+			if (argument == "tracesize")
+			{
+				cfin >> trace_size;
+				continue;
+			}
+			keys.pop_back();
+			unknown.push_back(argument);
+		}
+		if (compact)
+		{
+			// The compact agent only has a seed, an exploration constant and a simulation budget
+			for (const std::string &key : keys)
+			{
+				if (key != "seed" && key != "c" && key != "scount" && key != "loginterval" && key != "compact")
+				{
+					std::cerr << "The compact agent does not support " << key << std::endl;
+					unknown.push_back(key);
+				}
+			}
+			return std::make_unique<CompactMCTSAgent>(seed, c, simulate_count, log_interval);
+		}
+		std::unique_ptr<MCTSAgent> agent = std::make_unique<MCTSAgent>(seed, c, simulate_count, log_interval, ponder, ponder_memory << 20, rave, max_memory << 20, checkpoint, gumbel_count, move_time, compaction);
+		agent->checkpoint_interval = checkpoint_interval;
+		if (use_playout)
+		{
+			agent->set_playout(std::make_unique<AlphaYa::MNK::MNKPlayout<State>>(seed));
+		}
+		if (!trace.empty())
+		{
+			agent->set_trace(trace, trace_size);
+		}
+		return std::move(agent);
+	}
+
+	/*
+	MCTS agent of config, ignoring unknown words
+	*/
+	std::unique_ptr<Agent> mcts_agent(const std::string &config)
+	{
+		std::vector<std::string> unknown;
+		return configure_mcts_agent(config, unknown);
+	}
+
+	/*
+	Solver agent: play proven wins found by df-pn, and use the MCTS agent with the same config otherwise
+	time MS: time limit of df-pn in milliseconds
+	nodes N: node limit of df-pn, 0 for no limit
+	hash MB: size of the transposition table of df-pn
+	*/
+	std::unique_ptr<Agent> solver_agent(const std::string &config)
+	{
+		IndexType time_limit = 1000;
+		std::uint64_t node_limit = 0;
+		std::uint64_t hash_megabytes = 64;
+		std::string argument;
+		for (std::istringstream cfin(config);;)
+		{
+			cfin >> argument;
+			if (cfin.fail())
+			{
+				break;
+			}
+			if (argument == "time")
+			{
+				cfin >> time_limit;
+				continue;
+			}
+			if (argument == "nodes")
+			{
+				cfin >> node_limit;
+				continue;
+			}
+			if (argument == "hash")
+			{
+				cfin >> hash_megabytes;
+				continue;
+			}
+		}
+		return std::make_unique<SolverAgent>(mcts_agent(config), time_limit, node_limit, hash_megabytes << 20);
+	}
+
+	/*
+	Agent constructors
+	Format: AgentConstructor("name", "description", constructor, needconfig(bool))
+	*/
+	const AgentConstructor agent_constructors[] = {
+		AgentConstructor("human", "You", input_agent),
+		AgentConstructor("random", "Randomly moving bot", random_agent, true),
+		AgentConstructor("ai", "AI using MCTS algorithm", mcts_agent, true),
+		AgentConstructor("solver", "AI playing wins proven by df-pn, and using MCTS otherwise", solver_agent, true),
+	};
+
+	/*
+	Names of players
+	*/
+	const std::string player_names[players] = {"X", "O"};
+
+	/*
+	If allow_customize_state = true, user would be able to input a string as the initial state
+	*/
+	constexpr bool allow_customize_state = false;
+
+	/*
+	If allow_customize_state = true, default_state is the default initial state
+	If allow_customize_state = false, default_state is the only possible initial state
+	*/
+	const std::string default_state = "";
+
+	/*
+	Controls whether agent for each player can be customized
+	*/
+	const bool allow_customize_agents[players] = {true, true};
+
+	/*
+	The default agent for each player
+	*/
+	const std::string default_agents[players] = {"ai", "human"};
+
+	/*
+	The default agent config for each player
+	*/
+	const std::string default_agent_config[players] = {"", ""};
+
+	/*
+	Help string
+	This string will be printed when user executes ".help" command.
+	Please put the game's name, rule author, programmer and rule into this string.
+	Please use English if possible.
+	*/
+	const std::string help = "Tic-Tac-Toe\n"
+							 "Code: Ya\n"
+							 "\n"
+							 "Classic tic-tac-toe game.\n";
+
+	/*
+	Known perft results from default_state, indexed by depth
+	Used by the perft tool as a correctness check.
+	*/
+	const std::vector<std::uint64_t> perft_results = {1, 9, 72, 504, 3024, 15120, 54720, 148176, 200448, 127872};
+
+	/*
+	Record file prefix
+	Record files will be saved as records/<prefix>_<time>.txt
+	*/
+	const std::string record_prefix = "tictactoe";
 };
\ No newline at end of file
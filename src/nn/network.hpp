@@ -0,0 +1,215 @@
+#pragma once
+
+#include "../game/game.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ALPHAYA_NN_SSE
+#include <emmintrin.h>
+#endif
+
+namespace AlphaYa
+{
+	namespace NN
+	{
+		/*
+		Sum of a[k] * b[k] for k in [0, n)
+		*/
+		inline float dot(const float *a, const float *b, IndexType n)
+		{
+			IndexType k = 0;
+			float sum = 0;
+#ifdef ALPHAYA_NN_SSE
+			__m128 sum0 = _mm_setzero_ps(), sum1 = _mm_setzero_ps();
+			for (; k + 8 <= n; k += 8)
+			{
+				sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + k), _mm_loadu_ps(b + k)));
+				sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(a + k + 4), _mm_loadu_ps(b + k + 4)));
+			}
+			float lanes[4];
+			_mm_storeu_ps(lanes, _mm_add_ps(sum0, sum1));
+			sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+			for (; k < n; ++k)
+			{
+				sum += a[k] * b[k];
+			}
+			return sum;
+		}
+
+		/*
+		y[k] += alpha * x[k] for k in [0, n)
+		*/
+		inline void axpy(float alpha, const float *x, float *y, IndexType n)
+		{
+			IndexType k = 0;
+#ifdef ALPHAYA_NN_SSE
+			const __m128 a = _mm_set1_ps(alpha);
+			for (; k + 4 <= n; k += 4)
+			{
+				_mm_storeu_ps(y + k, _mm_add_ps(_mm_loadu_ps(y + k), _mm_mul_ps(a, _mm_loadu_ps(x + k))));
+			}
+#endif
+			for (; k < n; ++k)
+			{
+				y[k] += alpha * x[k];
+			}
+		}
+
+		/*
+		Weight file format
+		A header of magic, step and the 4 layer sizes of Network, followed by all parameters as float,
+		in the byte order of the machine. magic reads "YAWEIGH1" on little-endian machines.
+		*/
+		constexpr std::uint64_t weights_magic = 0x3148474945574159;
+
+		/*
+		Small policy/value network over binary input features
+		hidden = clamp(b1 + sum of columns of W1 of the active features, 0, 1)
+		policy logits = bp + Wp hidden
+		value = tanh(bv + Wv clamp(b2 + W2 hidden, 0, 1))
+		The first layer is a sum of columns, so that it can be updated incrementally when features change,
+		and the clipped activations keep every layer in a fixed range for quantization.
+		All parameters are in one array, so that optimizers can treat them as one vector.
+		*/
+		class Network
+		{
+		public:
+			IndexType input_count, hidden_count, value_hidden_count, output_count;
+
+			/*
+			Number of optimizer steps the weights have been trained for
+			*/
+			std::uint64_t step;
+
+			std::vector<float> parameters;
+
+			/*
+			Offsets of layers in parameters
+			W1 is stored by input feature, and the other matrices by output, so every layer is a dot or axpy of rows.
+			*/
+			IndexType w1, b1, wp, bp, w2, b2, wv, bv;
+
+			/*
+			Activations of one forward pass
+			*/
+			class Activations
+			{
+			public:
+				std::vector<float> hidden_sum, hidden, logits, value_sum, value_hidden;
+				float value;
+			};
+
+			Network(IndexType i = 0, IndexType h = 0, IndexType vh = 0, IndexType o = 0) : input_count(i), hidden_count(h), value_hidden_count(vh), output_count(o), step(0)
+			{
+				layout();
+			}
+
+			void layout()
+			{
+				w1 = 0;
+				b1 = w1 + input_count * hidden_count;
+				wp = b1 + hidden_count;
+				bp = wp + output_count * hidden_count;
+				w2 = bp + output_count;
+				b2 = w2 + value_hidden_count * hidden_count;
+				wv = b2 + value_hidden_count;
+				bv = wv + value_hidden_count;
+				parameters.assign(bv + 1, 0.0f);
+			}
+
+			/*
+			Random initial weights, scaled by the number of inputs of each layer
+			*/
+			void randomize(std::uint64_t seed)
+			{
+				std::mt19937_64 engine(seed);
+				const auto fill = [&](IndexType begin, IndexType end, float deviation)
+				{
+					std::normal_distribution<float> distribution(0.0f, deviation);
+					for (IndexType k = begin; k < end; ++k)
+					{
+						parameters[k] = distribution(engine);
+					}
+				};
+				fill(w1, b1, 0.1f);
+				std::fill(parameters.begin() + b1, parameters.begin() + wp, 0.5f);
+				fill(wp, bp, 1.0f / std::sqrt((float)hidden_count));
+				fill(w2, b2, 1.0f / std::sqrt((float)hidden_count));
+				std::fill(parameters.begin() + b2, parameters.begin() + wv, 0.5f);
+				fill(wv, bv, 1.0f / std::sqrt((float)value_hidden_count));
+				step = 0;
+			}
+
+			void forward(const std::uint16_t features[], IndexType count, Activations &activations) const
+			{
+				const float *p = parameters.data();
+				activations.hidden_sum.assign(p + b1, p + b1 + hidden_count);
+				for (IndexType f = 0; f < count; ++f)
+				{
+					axpy(1.0f, p + w1 + features[f] * hidden_count, activations.hidden_sum.data(), hidden_count);
+				}
+				activations.hidden.resize(hidden_count);
+				for (IndexType h = 0; h < hidden_count; ++h)
+				{
+					activations.hidden[h] = std::min(std::max(activations.hidden_sum[h], 0.0f), 1.0f);
+				}
+				activations.logits.resize(output_count);
+				for (IndexType o = 0; o < output_count; ++o)
+				{
+					activations.logits[o] = p[bp + o] + dot(p + wp + o * hidden_count, activations.hidden.data(), hidden_count);
+				}
+				activations.value_sum.resize(value_hidden_count);
+				activations.value_hidden.resize(value_hidden_count);
+				for (IndexType k = 0; k < value_hidden_count; ++k)
+				{
+					activations.value_sum[k] = p[b2 + k] + dot(p + w2 + k * hidden_count, activations.hidden.data(), hidden_count);
+					activations.value_hidden[k] = std::min(std::max(activations.value_sum[k], 0.0f), 1.0f);
+				}
+				activations.value = std::tanh(p[bv] + dot(p + wv, activations.value_hidden.data(), value_hidden_count));
+			}
+
+			/*
+			Returns false on failure
+			*/
+			bool save(const std::string &path) const
+			{
+				std::ofstream fout(path, std::ios::binary | std::ios::trunc);
+				const std::uint64_t header[6] = {weights_magic, step, input_count, hidden_count, value_hidden_count, output_count};
+				fout.write((const char *)header, sizeof(header));
+				fout.write((const char *)parameters.data(), parameters.size() * sizeof(float));
+				fout.close();
+				return !fout.fail();
+			}
+
+			/*
+			Returns false if path is not a weight file
+			*/
+			bool load(const std::string &path)
+			{
+				std::ifstream fin(path, std::ios::binary);
+				std::uint64_t header[6];
+				fin.read((char *)header, sizeof(header));
+				if (fin.fail() || header[0] != weights_magic)
+				{
+					return false;
+				}
+				input_count = (IndexType)header[2];
+				hidden_count = (IndexType)header[3];
+				value_hidden_count = (IndexType)header[4];
+				output_count = (IndexType)header[5];
+				layout();
+				fin.read((char *)parameters.data(), parameters.size() * sizeof(float));
+				step = header[1];
+				return !fin.fail();
+			}
+		};
+	};
+};
\ No newline at end of file
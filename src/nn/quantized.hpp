@@ -0,0 +1,253 @@
+#pragma once
+
+#include "../game/game.hpp"
+#include "network.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace AlphaYa
+{
+	namespace NN
+	{
+		/*
+		a[k] += b[k] for k in [0, n) in 16 bits, n a multiple of 8
+		*/
+		inline void add16(std::int16_t *a, const std::int16_t *b, IndexType n)
+		{
+			IndexType k = 0;
+#ifdef ALPHAYA_NN_SSE
+			for (; k < n; k += 8)
+			{
+				_mm_storeu_si128((__m128i *)(a + k), _mm_add_epi16(_mm_loadu_si128((const __m128i *)(a + k)), _mm_loadu_si128((const __m128i *)(b + k))));
+			}
+#endif
+			for (; k < n; ++k)
+			{
+				a[k] = (std::int16_t)(a[k] + b[k]);
+			}
+		}
+
+		/*
+		b[k] = clamp(a[k], 0, high) for k in [0, n), n a multiple of 8
+		*/
+		inline void clamp16(const std::int16_t *a, std::int16_t *b, std::int16_t high, IndexType n)
+		{
+			IndexType k = 0;
+#ifdef ALPHAYA_NN_SSE
+			const __m128i zero = _mm_setzero_si128(), top = _mm_set1_epi16(high);
+			for (; k < n; k += 8)
+			{
+				_mm_storeu_si128((__m128i *)(b + k), _mm_min_epi16(_mm_max_epi16(_mm_loadu_si128((const __m128i *)(a + k)), zero), top));
+			}
+#endif
+			for (; k < n; ++k)
+			{
+				b[k] = std::min(std::max(a[k], (std::int16_t)0), high);
+			}
+		}
+
+		/*
+		Sum of a[k] * b[k] for k in [0, n) in 32 bits, n a multiple of 8
+		Products of pairs are summed in 32 bits by pmaddwd, so a[k] * b[k] + a[k + 1] * b[k + 1] must fit.
+		*/
+		inline std::int32_t dot16(const std::int16_t *a, const std::int16_t *b, IndexType n)
+		{
+			IndexType k = 0;
+			std::int32_t sum = 0;
+#ifdef ALPHAYA_NN_SSE
+			__m128i sum0 = _mm_setzero_si128(), sum1 = _mm_setzero_si128();
+			for (; k + 16 <= n; k += 16)
+			{
+				sum0 = _mm_add_epi32(sum0, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(a + k)), _mm_loadu_si128((const __m128i *)(b + k))));
+				sum1 = _mm_add_epi32(sum1, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(a + k + 8)), _mm_loadu_si128((const __m128i *)(b + k + 8))));
+			}
+			for (; k < n; k += 8)
+			{
+				sum0 = _mm_add_epi32(sum0, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(a + k)), _mm_loadu_si128((const __m128i *)(b + k))));
+			}
+			sum0 = _mm_add_epi32(sum0, sum1);
+			sum0 = _mm_add_epi32(sum0, _mm_shuffle_epi32(sum0, 0x4E));
+			sum0 = _mm_add_epi32(sum0, _mm_shuffle_epi32(sum0, 0xB1));
+			sum = _mm_cvtsi128_si32(sum0);
+#endif
+			for (; k < n; ++k)
+			{
+				sum += a[k] * b[k];
+			}
+			return sum;
+		}
+
+		/*
+		Integer version of Network for incremental evaluation
+		Activations in [0, 1] are scaled by activation_scale into [0, 127], and the weights of the layers above
+		the first are scaled by weight_scale and rounded into the 8-bit range [-127, 127], so the weights
+		of the trained float network should stay within 127 / 64 for accuracy.
+		The first layer is kept as 16-bit columns scaled by activation_scale, and its sum over the active features
+		is the accumulator, which is updated by adding one column per new feature.
+		The 8-bit weights are stored in 16-bit lanes, since SSE2 multiplies 16-bit lanes (pmaddwd).
+		Layer widths are padded to multiples of 8 with zero weights.
+		*/
+		class QuantizedNetwork
+		{
+		public:
+			static constexpr std::int32_t activation_scale = 127;
+			static constexpr std::int32_t weight_scale = 64;
+
+			IndexType input_count, hidden_count, value_hidden_count, output_count;
+
+			/*
+			Widths of hidden layers padded to multiples of 8
+			*/
+			IndexType hidden_width, value_hidden_width;
+
+			/*
+			Columns of W1 and b1 are hidden_width wide, and rows of W2 and Wp are hidden_width wide
+			Biases b2 and bp are scaled by activation_scale * weight_scale.
+			*/
+			std::vector<std::int16_t> w1, b1, w2, wp, wv;
+			std::vector<std::int32_t> b2, bp;
+			float bv;
+
+			QuantizedNetwork() : input_count(0), hidden_count(0), value_hidden_count(0), output_count(0), hidden_width(0), value_hidden_width(0), bv(0) {}
+
+			static IndexType pad(IndexType n)
+			{
+				return (n + 7) / 8 * 8;
+			}
+
+			static std::int16_t quantize(float x, float scale, float limit)
+			{
+				return (std::int16_t)std::lround(std::min(std::max(x * scale, -limit), limit));
+			}
+
+			/*
+			Quantize network, whose inputs have at most one active feature among features f, f + stride, f + 2 * stride...
+			for every f, such as the own and opposing stone of a cell
+			Returns false if an accumulator may overflow 16 bits.
+			*/
+			bool assign(const Network &network, IndexType stride)
+			{
+				input_count = network.input_count;
+				hidden_count = network.hidden_count;
+				value_hidden_count = network.value_hidden_count;
+				output_count = network.output_count;
+				hidden_width = pad(hidden_count);
+				value_hidden_width = pad(value_hidden_count);
+				const float *p = network.parameters.data();
+
+				w1.assign(input_count * hidden_width, 0);
+				b1.assign(hidden_width, 0);
+				std::vector<std::int64_t> bounds(hidden_count);
+				for (IndexType h = 0; h < hidden_count; ++h)
+				{
+					b1[h] = quantize(p[network.b1 + h], activation_scale, 32767);
+					bounds[h] = std::abs((std::int64_t)b1[h]);
+				}
+				for (IndexType first = 0; first < std::min(stride, input_count); ++first)
+				{
+					for (IndexType h = 0; h < hidden_count; ++h)
+					{
+						std::int64_t largest = 0;
+						for (IndexType f = first; f < input_count; f += stride)
+						{
+							w1[f * hidden_width + h] = quantize(p[network.w1 + f * hidden_count + h], activation_scale, 32767);
+							largest = std::max(largest, (std::int64_t)std::abs((std::int64_t)w1[f * hidden_width + h]));
+						}
+						bounds[h] += largest;
+					}
+				}
+				if (hidden_count && *std::max_element(bounds.begin(), bounds.end()) > 32767)
+				{
+					return false;
+				}
+
+				const float bias_scale = (float)(activation_scale * weight_scale);
+				w2.assign(value_hidden_count * hidden_width, 0);
+				b2.resize(value_hidden_count);
+				for (IndexType k = 0; k < value_hidden_count; ++k)
+				{
+					for (IndexType h = 0; h < hidden_count; ++h)
+					{
+						w2[k * hidden_width + h] = quantize(p[network.w2 + k * hidden_count + h], weight_scale, 127);
+					}
+					b2[k] = (std::int32_t)std::lround(p[network.b2 + k] * bias_scale);
+				}
+				wp.assign(output_count * hidden_width, 0);
+				bp.resize(output_count);
+				for (IndexType o = 0; o < output_count; ++o)
+				{
+					for (IndexType h = 0; h < hidden_count; ++h)
+					{
+						wp[o * hidden_width + h] = quantize(p[network.wp + o * hidden_count + h], weight_scale, 127);
+					}
+					bp[o] = (std::int32_t)std::lround(p[network.bp + o] * bias_scale);
+				}
+				wv.assign(value_hidden_width, 0);
+				for (IndexType k = 0; k < value_hidden_count; ++k)
+				{
+					wv[k] = quantize(p[network.wv + k], weight_scale, 127);
+				}
+				bv = p[network.bv];
+				return true;
+			}
+
+			/*
+			Returns false if path is not a weight file or cannot be quantized
+			*/
+			bool load(const std::string &path, IndexType stride)
+			{
+				Network network;
+				return network.load(path) && assign(network, stride);
+			}
+
+			/*
+			Write b1 into accumulator, which is hidden_width wide
+			*/
+			void reset(std::int16_t *accumulator) const
+			{
+				std::copy(b1.begin(), b1.end(), accumulator);
+			}
+
+			void add(std::int16_t *accumulator, IndexType feature) const
+			{
+				add16(accumulator, w1.data() + feature * hidden_width, hidden_width);
+			}
+
+			/*
+			Clipped hidden layer of accumulator, hidden_width wide
+			*/
+			void activate(const std::int16_t *accumulator, std::int16_t *hidden) const
+			{
+				clamp16(accumulator, hidden, (std::int16_t)activation_scale, hidden_width);
+			}
+
+			/*
+			Value of hidden in (-1, 1)
+			value_hidden is a buffer of value_hidden_width.
+			*/
+			float value(const std::int16_t *hidden, std::int16_t *value_hidden) const
+			{
+				for (IndexType k = 0; k < value_hidden_count; ++k)
+				{
+					const std::int32_t sum = b2[k] + dot16(w2.data() + k * hidden_width, hidden, hidden_width);
+					value_hidden[k] = (std::int16_t)std::min(std::max(sum / weight_scale, 0), (std::int32_t)activation_scale);
+				}
+				std::fill(value_hidden + value_hidden_count, value_hidden + value_hidden_width, 0);
+				return std::tanh(bv + (float)dot16(wv.data(), value_hidden, value_hidden_width) / (float)(activation_scale * weight_scale));
+			}
+
+			/*
+			Policy logit of output o for hidden
+			*/
+			float logit(const std::int16_t *hidden, IndexType o) const
+			{
+				return (float)(bp[o] + dot16(wp.data() + o * hidden_width, hidden, hidden_width)) / (float)(activation_scale * weight_scale);
+			}
+		};
+	};
+};
\ No newline at end of file
@@ -0,0 +1,222 @@
+#pragma once
+
+#include "../game/game.hpp"
+#include "../game/thread_pool.hpp"
+#include "network.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace AlphaYa
+{
+	namespace NN
+	{
+		/*
+		Training sample: active input features, outputs which are legal for the policy,
+		the output played, and the final result for the player to move in [-1, 1]
+		*/
+		class Sample
+		{
+		public:
+			std::vector<std::uint16_t> features;
+			std::vector<std::uint16_t> legal;
+			IndexType policy;
+			float value;
+		};
+
+		/*
+		Mini-batch trainer of Network
+		The loss of a sample is the cross entropy of the policy over the legal outputs, plus the squared error of the value.
+		A batch is split among threads, every thread backpropagates its samples into its own gradient,
+		and the gradients are summed for one step of Adam, or SGD with momentum.
+		The calling thread takes the share of thread 0, and the other shares run on a pool of thread_count - 1 threads.
+		Moments start at 0 with every trainer, so the bias correction of Adam counts the steps of the trainer,
+		not the steps the weights have been trained for, which keeps it right when training resumes from a weight file.
+		See: https://arxiv.org/abs/1412.6980
+		*/
+		class Trainer
+		{
+		public:
+			Network &network;
+			IndexType thread_count;
+			bool adam;
+			float learning_rate, decay, beta1, beta2, epsilon;
+
+			std::vector<std::vector<float>> gradients;
+
+			/*
+			Moving averages of gradients and squared gradients of Adam, and velocity of SGD in moment1
+			*/
+			std::vector<float> moment1, moment2;
+
+			/*
+			Number of steps of this trainer
+			*/
+			IndexType steps;
+
+			/*
+			Sum of losses of the samples of every thread in the last step
+			*/
+			std::vector<double> policy_losses, value_losses;
+
+			std::unique_ptr<ThreadPool> pool;
+
+			Trainer(Network &n, IndexType t, bool a, float lr, float d) : network(n), thread_count(std::max(t, (IndexType)1)), adam(a), learning_rate(lr), decay(d), beta1(0.9f), beta2(0.999f), epsilon(1e-8f), steps(0)
+			{
+				if (thread_count > 1)
+				{
+					pool = std::make_unique<ThreadPool>(thread_count - 1);
+				}
+				gradients.resize(thread_count);
+				moment1.assign(network.parameters.size(), 0.0f);
+				moment2.assign(network.parameters.size(), 0.0f);
+				policy_losses.resize(thread_count);
+				value_losses.resize(thread_count);
+			}
+
+			/*
+			Add the gradient of the loss of sample into gradient, and the losses into policy_loss and value_loss
+			*/
+			void backward(const Sample &sample, Network::Activations &activations, std::vector<float> &gradient, std::vector<float> &hidden_gradient, double &policy_loss, double &value_loss) const
+			{
+				const Network &n = network;
+				const float *p = n.parameters.data();
+				float *g = gradient.data();
+				n.forward(sample.features.data(), sample.features.size(), activations);
+				hidden_gradient.assign(n.hidden_count, 0.0f);
+
+				// Value head
+				const float error = activations.value - sample.value;
+				value_loss += error * error;
+				const float value_gradient = 2 * error * (1 - activations.value * activations.value);
+				g[n.bv] += value_gradient;
+				for (IndexType k = 0; k < n.value_hidden_count; ++k)
+				{
+					g[n.wv + k] += value_gradient * activations.value_hidden[k];
+					const float sum = activations.value_sum[k];
+					if (sum > 0 && sum < 1)
+					{
+						const float sum_gradient = value_gradient * p[n.wv + k];
+						g[n.b2 + k] += sum_gradient;
+						axpy(sum_gradient, activations.hidden.data(), g + n.w2 + k * n.hidden_count, n.hidden_count);
+						axpy(sum_gradient, p + n.w2 + k * n.hidden_count, hidden_gradient.data(), n.hidden_count);
+					}
+				}
+
+				// Policy head, softmax over legal outputs
+				float max_logit = activations.logits[sample.policy];
+				for (const std::uint16_t o : sample.legal)
+				{
+					max_logit = std::max(max_logit, activations.logits[o]);
+				}
+				double total = 0;
+				for (const std::uint16_t o : sample.legal)
+				{
+					total += std::exp(activations.logits[o] - max_logit);
+				}
+				policy_loss += std::log(total) - (activations.logits[sample.policy] - max_logit);
+				for (const std::uint16_t o : sample.legal)
+				{
+					const float logit_gradient = (float)(std::exp(activations.logits[o] - max_logit) / total) - (o == sample.policy);
+					g[n.bp + o] += logit_gradient;
+					axpy(logit_gradient, activations.hidden.data(), g + n.wp + o * n.hidden_count, n.hidden_count);
+					axpy(logit_gradient, p + n.wp + o * n.hidden_count, hidden_gradient.data(), n.hidden_count);
+				}
+
+				// First layer, only the columns of active features
+				for (IndexType h = 0; h < n.hidden_count; ++h)
+				{
+					const float sum = activations.hidden_sum[h];
+					hidden_gradient[h] = sum > 0 && sum < 1 ? hidden_gradient[h] : 0.0f;
+				}
+				axpy(1.0f, hidden_gradient.data(), g + n.b1, n.hidden_count);
+				for (const std::uint16_t f : sample.features)
+				{
+					axpy(1.0f, hidden_gradient.data(), g + n.w1 + f * n.hidden_count, n.hidden_count);
+				}
+			}
+
+			/*
+			One optimizer step on the mean loss of batch
+			Mean losses of the batch are written into policy_loss and value_loss.
+			*/
+			void step(const std::vector<Sample> &batch, double &policy_loss, double &value_loss)
+			{
+				const IndexType size = network.parameters.size();
+				const auto work = [&](IndexType t)
+				{
+					std::vector<float> &gradient = gradients[t];
+					gradient.assign(size, 0.0f);
+					policy_losses[t] = value_losses[t] = 0;
+					Network::Activations activations;
+					std::vector<float> hidden_gradient;
+					for (IndexType i = t; i < batch.size(); i += thread_count)
+					{
+						backward(batch[i], activations, gradient, hidden_gradient, policy_losses[t], value_losses[t]);
+					}
+				};
+				std::vector<std::future<void>> done;
+				for (IndexType t = 1; t < thread_count; ++t)
+				{
+					std::shared_ptr<std::packaged_task<void()>> task = std::make_shared<std::packaged_task<void()>>([&work, t]()
+					{
+						work(t);
+					});
+					done.push_back(task->get_future());
+					pool->submit([task]()
+					{
+						(*task)();
+					});
+				}
+				work(0);
+				for (std::future<void> &result : done)
+				{
+					result.get();
+				}
+				policy_loss = value_loss = 0;
+				for (IndexType t = 0; t < thread_count; ++t)
+				{
+					if (t)
+					{
+						axpy(1.0f, gradients[t].data(), gradients[0].data(), size);
+					}
+					policy_loss += policy_losses[t];
+					value_loss += value_losses[t];
+				}
+				policy_loss /= batch.size();
+				value_loss /= batch.size();
+
+				++network.step;
+				++steps;
+				float *p = network.parameters.data();
+				const float *g = gradients[0].data();
+				const float scale = 1.0f / batch.size();
+				if (adam)
+				{
+					const float correction1 = 1 - std::pow(beta1, (float)steps);
+					const float correction2 = 1 - std::pow(beta2, (float)steps);
+					const float rate = learning_rate * std::sqrt(correction2) / correction1;
+					for (IndexType k = 0; k < size; ++k)
+					{
+						const float gradient = g[k] * scale + decay * p[k];
+						moment1[k] = beta1 * moment1[k] + (1 - beta1) * gradient;
+						moment2[k] = beta2 * moment2[k] + (1 - beta2) * gradient * gradient;
+						p[k] -= rate * moment1[k] / (std::sqrt(moment2[k]) + epsilon);
+					}
+				}
+				else
+				{
+					for (IndexType k = 0; k < size; ++k)
+					{
+						moment1[k] = beta1 * moment1[k] + g[k] * scale + decay * p[k];
+						p[k] -= learning_rate * moment1[k];
+					}
+				}
+			}
+		};
+	};
+};
\ No newline at end of file